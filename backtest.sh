@@ -1,3 +1,6 @@
 #!/bin/bash
 
-node --nouse-idle-notification --max-old-space-size=31000 --expose-gc `which gulp` backtest --symbol $1 --parser metatrader --data ./data/metatrader/$1.csv --optimizer Trend --investment 1000 --profitability 0.76 --database forex-backtesting
+# Optimizes each symbol given, e.g. ./backtest.sh AUDJPY EURJPY.
+symbols=$(IFS=,; echo "$*")
+
+node --nouse-idle-notification --max-old-space-size=31000 `which gulp` backtest --symbols $symbols --parser metatrader --data ./data/metatrader/{symbol}.csv --optimizer Trend --investment 1000 --profitability 0.76 --database forex-backtesting
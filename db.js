@@ -1,7 +1,7 @@
 var mongoose = require('mongoose');
 
-module.exports.initialize = function(dbName) {
-    var dbUri = 'mongodb://localhost/' + dbName;
+module.exports.initialize = function(dbName, host) {
+    var dbUri = 'mongodb://' + (host || 'localhost') + '/' + dbName;
 
     mongoose.connect(dbUri);
     mongoose.connection.on('error', console.error.bind(console, 'Database connection error:'));
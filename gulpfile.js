@@ -3,8 +3,9 @@ var gutil = require('gulp-util');
 var argv = require('yargs').argv;
 var path = require('path');
 var _ = require('lodash');
-var async = require('async');
 var slice = require('sliced');
+var metrics = require('./src/metrics');
+var progress = require('./src/progress');
 
 var garbageCollectionTimeout = null;
 
@@ -13,11 +14,15 @@ function scheduleGarbageCollection() {
         return;
     }
     garbageCollectionTimeout = setTimeout(function() {
+        var stopTimer = null;
+
         // Allow the timeout to be garbage collected.
         garbageCollectionTimeout = null;
 
         // Collect garbage.
+        stopTimer = metrics.time('garbageCollection');
         global.gc();
+        stopTimer();
 
         // Re-schedule garbage collection.
         scheduleGarbageCollection();
@@ -31,10 +36,30 @@ Array.prototype.slice = function(begin, end) {
 
 scheduleGarbageCollection();
 
+// Logs metrics (see src/metrics.js) as lines of JSON to the file given with --metrics, every
+// --metrics-interval seconds.
+function startMetrics() {
+    if (argv.metrics) {
+        metrics.startReporting(argv.metrics, (parseFloat(argv['metrics-interval']) || 10) * 1000);
+    }
+}
+
+function stopMetrics() {
+    if (argv.metrics) {
+        metrics.stopReporting();
+    }
+}
+
 gulp.task('backtest', function(done) {
     function showUsageInfo() {
         console.log('Example usage:\n');
         console.log('gulp backtest --symbol AUDJPY --parser metatrader --data ./data/metatrader/three-year/AUDJPY.csv --optimizer Reversals --investment 1000 --profitability 0.7 --database forex-backtesting\n');
+        console.log('Add --aggregate to keep only backtest results, and --constraints \'{"winRate": {"$gte": 0.62}}\' to then save positions only for backtests satisfying the constraints.\n');
+        console.log('Add --coordinator 8080 to have agents (see the agent task) backtest configurations instead of local processes, and --lease-timeout 60 to change how many seconds agents have to renew leases.\n');
+        console.log('To optimize several symbols in one run, use --symbols AUDJPY,EURJPY with --data ./data/metatrader/{symbol}.csv (or a comma-separated list of data files).\n');
+        console.log('Add --metrics ./data/metrics.log to log timings, throughput and memory use every --metrics-interval seconds (10 by default).\n');
+        console.log('Add --write-concern 0 to not wait for MongoDB to acknowledge inserts of backtests and positions (or e.g. --write-concern majority for replica sets).\n');
+        console.log('Add --prune to stop backtesting configurations as soon as they cannot satisfy the constraints used by the forwardtest task (or --prune \'{"maximumConsecutiveLosses": {"$lte": 10}}\' for other constraints). They are saved as pruned, with results up to that point.\n');
     }
 
     function handleInputError(message) {
@@ -46,17 +71,44 @@ gulp.task('backtest', function(done) {
     var db = require('./db');
     var dataParsers = require('./src/dataParsers');
     var optimizers = require('./src/optimizers');
+    var batch = require('./src/optimizers/batch');
+    var constraints = require('./src/constraints');
 
     var optimizerFn;
     var dataParser;
     var investment = 0.0;
     var profitability = 0.0;
+    var jobs = [];
 
-    // Find the symbol based on the command line argument.
-    if (!argv.symbol) {
+    // Find the symbol (or symbols) based on the command line argument.
+    if (!argv.symbol && !argv.symbols) {
         handleInputError('No symbol provided');
     }
 
+    // Pair each symbol with its data file.
+    if (argv.symbols) {
+        if (!argv.data) {
+            handleInputError('No data file provided');
+        }
+
+        jobs = String(argv.symbols).split(',').map(function(symbol, index, symbols) {
+            var dataFilePaths = String(argv.data).split(',');
+
+            if (dataFilePaths.length !== symbols.length && argv.data.indexOf('{symbol}') === -1) {
+                handleInputError('Provide one data file per symbol or a data file path containing {symbol}');
+            }
+
+            return {
+                symbol: symbol,
+                dataFilePath: dataFilePaths.length === symbols.length ? dataFilePaths[index] : argv.data.replace(/\{symbol\}/g, symbol)
+            };
+        });
+
+        if (argv.coordinator) {
+            handleInputError('Coordinating is only supported for one symbol at a time');
+        }
+    }
+
     // Find the raw data parser based on command line argument.
     dataParser = dataParsers[argv.parser]
     if (!dataParser) {
@@ -86,17 +138,86 @@ gulp.task('backtest', function(done) {
     // Set up database connection.
     db.initialize(argv.database);
 
-    try {
-        // Parse the raw data file.
-        dataParser.parse(argv.data).then(function(parsedData) {
-            // Prepare the strategy.
-            var optimizer = new optimizerFn(argv.symbol);
+    function configure(optimizer) {
+        // Keep only results during the run, optionally saving positions afterwards for backtests that
+        // satisfy the given constraints.
+        if (argv.aggregate || argv.constraints) {
+            optimizer.setAggregateOnly(argv.constraints ? constraints.parse(argv.constraints) : null);
+        }
+
+        // Stop backtesting configurations that cannot pass the downstream filters.
+        if (argv.prune) {
+            optimizer.setPruning(argv.prune === true ? constraints.defaults : constraints.parse(argv.prune));
+        }
+
+        // Trade durability for insert throughput (or the other way around), if asked.
+        if (argv['write-concern'] !== undefined) {
+            optimizer.setWriteConcern(isNaN(argv['write-concern']) ? String(argv['write-concern']) : Number(argv['write-concern']));
+        }
+
+        // Serve configurations to remote agents rather than backtesting them locally.
+        if (argv.coordinator) {
+            optimizer.setCoordinator(parseInt(argv.coordinator), (parseFloat(argv['lease-timeout']) || 60) * 1000);
+        }
+    }
 
-            // Backtest the strategy against the parsed data.
-            optimizer.optimize(parsedData, investment, profitability, function() {
+    startMetrics();
+
+    try {
+        // Optimize several symbols, preparing each one's data while the previous one is optimized.
+        if (jobs.length) {
+            batch.run(argv.optimizer, argv.parser, jobs, investment, profitability, configure, function() {
+                stopMetrics();
                 db.disconnect();
                 done();
             });
+            return;
+        }
+
+        // Prepare the strategy.
+        var optimizer = new optimizerFn(argv.symbol);
+
+        configure(optimizer);
+
+        // Backtest the strategy against the data, parsing the raw data file only if it is not already cached.
+        optimizer.optimize(dataParser, argv.data, investment, profitability, function() {
+            stopMetrics();
+            db.disconnect();
+            done();
+        });
+    }
+    catch (error) {
+        console.error(error.message || error);
+        process.exit(1);
+    }
+});
+
+gulp.task('agent', function(done) {
+    function showUsageInfo() {
+        console.log('Example usage:\n');
+        console.log('gulp agent --coordinator http://192.168.1.10:8080 --workers 8\n');
+        console.log('Positions are saved to the database on the coordinator host unless --database-host is given. Add --metrics ./data/metrics.log to log metrics for the agent and its workers.\n');
+    }
+
+    function handleInputError(message) {
+        gutil.log(gutil.colors.red(message));
+        showUsageInfo();
+        process.exit(1);
+    }
+
+    var Agent = require('./src/optimizers/Agent');
+
+    if (!argv.coordinator) {
+        handleInputError('No coordinator URL provided');
+    }
+
+    startMetrics();
+
+    try {
+        // Backtest configurations leased from the coordinator until there are none left.
+        new Agent(argv.coordinator, parseInt(argv.workers) || 0, argv['database-host']).run(function() {
+            stopMetrics();
+            done();
         });
     }
     catch (error) {
@@ -109,6 +230,7 @@ gulp.task('forwardtest', function(done) {
     function showUsageInfo() {
         console.log('Example usage:\n');
         console.log('gulp forwardtest --symbol AUDJPY --parser ctoption --data ./data/ctoption/AUDJPY.csv --investment 1000 --profitability 0.7 --database forex-backtesting\n');
+        console.log('Add --metrics ./data/metrics.log to log timings, throughput and memory use.\n');
     }
 
     function handleInputError(message) {
@@ -119,22 +241,24 @@ gulp.task('forwardtest', function(done) {
 
     var db = require('./db');
     var dataParsers = require('./src/dataParsers');
+    var StudyCache = require('./src/StudyCache');
     var Backtest = require('./src/models/Backtest');
     var Forwardtest = require('./src/models/Forwardtest');
     var optimizerFn = require('./src/optimizers/Reversals');
     var strategyFn = require('./src/strategies/combined/Reversals');
+    var constraints = require('./src/constraints');
     var dataParser;
     var investment = 0.0;
     var profitability = 0.0;
 
-    var backtestConstraints = {
+    // Backtests over walk-forward windows are left to the walkforward task, and pruned backtests only
+    // cover part of the data.
+    var backtestConstraints = _.extend({
         symbol: argv.symbol,
         //strategyName: argv.strategy,
-        minimumProfitLoss: {'$gte': -20000},
-        maximumConsecutiveLosses: {'$lte': 10},
-        winRate: {'$gte': 0.62},
-        tradeCount: {'$gte': 1000},
-    };
+        inSampleStart: {'$exists': false},
+        pruned: {'$ne': true}
+    }, constraints.defaults);
 
     // Find the symbol based on the command line argument.
     if (!argv.symbol) {
@@ -169,241 +293,507 @@ gulp.task('forwardtest', function(done) {
     // Set up database connection.
     db.initialize(argv.database);
 
+    startMetrics();
+
     try {
-        dataParser.parse(argv.data).then(function(parsedData) {
-            var studyDefinitions = optimizerFn.studyDefinitions;
-            var studies = [];
-            var cumulativeData = [];
-            var previousDataPoint = null;
-            var dataCount = parsedData.length;
-
-            process.stdout.write('Preparing study data...');
-
-            // Prepare studies.
-            studyDefinitions.forEach(function(studyDefinition) {
-                // Instantiate the study, and add it to the list of studies for this strategy.
-                studies.push(new studyDefinition.study(studyDefinition.inputs, studyDefinition.outputMap));
-            });
+        // Studies start over wherever there is a significant gap in the data.
+        var studyCache = new StudyCache(argv.symbol, argv.data, 600000);
+        var showProgress = progress.create(23);
+        var stopTimer = metrics.time('prepareStudyData');
 
-            // Parepare study data.
-            parsedData.forEach(function(dataPoint, index) {
-                // If there is a significant gap, start over.
-                if (previousDataPoint && (dataPoint.timestamp - previousDataPoint.timestamp) > 600000) {
-                    cumulativeData = [];
-                }
+        process.stdout.write('Preparing study data...');
+
+        // Compute only the studies that are not already cached for the data file.
+        studyCache.prepare(optimizerFn.studyDefinitions, dataParser, function(dataPointCount, done) {
+            showProgress(dataPointCount + ' data points completed', done);
+        }, function() {
+            var store = studyCache.getStore();
+            var parsedData = null;
 
-                // Add the data point to the cumulative data.
-                cumulativeData.push(dataPoint);
+            stopTimer();
+            stopTimer = metrics.time('readDataPoints');
+            parsedData = store.readDataPoints(0, store.getCount());
+            stopTimer();
 
-                // Iterate over each study...
-                studies.forEach(function(study) {
-                    var studyProperty = '';
-                    var studyTickValues = {};
-                    var studyOutputs = study.getOutputMappings();
+            store.close();
+            process.stdout.write('\n');
 
-                    // Update the data for the study.
-                    study.setData(cumulativeData);
+            Backtest.find(backtestConstraints, metrics.timeCallback('mongo.find.backtests', function(error, backtests) {
+                var backtestCount = backtests.length;
+                var strategies = [];
+                var forwardtests = [];
 
-                    studyTickValues = study.tick();
+                process.stdout.write('Forward testing ' + backtestCount + ' backtests...');
 
-                    // Augment the last data point with the data the study generates.
-                    for (studyProperty in studyOutputs) {
-                        if (studyTickValues && typeof studyTickValues[studyOutputs[studyProperty]] === 'number') {
-                            dataPoint[studyOutputs[studyProperty]] = studyTickValues[studyOutputs[studyProperty]];
-                        }
-                        else {
-                            dataPoint[studyOutputs[studyProperty]] = '';
-                        }
-                    }
+                // Set up a strategy instance for each backtest.
+                strategies = backtests.map(function(backtest) {
+                    var strategy = new strategyFn(argv.symbol, [backtest.configuration]);
 
-                    // Ensure memory is freed.
-                    studyTickValues = null;
+                    strategy.setProfitLoss(10000);
+
+                    return strategy;
                 });
 
-                previousDataPoint = dataPoint;
+                // Backtest (forward test) every strategy in a single pass over the data.
+                stopTimer = metrics.time('forwardtest');
+                forwardtests = strategyFn.backtestAll(strategies, parsedData, investment, profitability).map(function(results, index) {
+                    return _.extend(results, {
+                        symbol: argv.symbol,
+                        strategyUuid: backtests[index].strategyUuid,
+                        configuration: backtests[index].configuration
+                    });
+                });
 
-                process.stdout.cursorTo(23);
-                process.stdout.write(index + ' of ' + dataCount + ' completed');
-            });
+                stopTimer();
+                metrics.increment('dataPoints', strategies.length * parsedData.length);
 
-            process.stdout.cursorTo(23);
-            process.stdout.write(dataCount + ' of ' + dataCount + ' completed\n');
+                process.stdout.write('done\n');
 
-            Backtest.find(backtestConstraints, function(error, backtests) {
-                var backtestCount = backtests.length;
-                var backtestTasks = [];
+                if (!forwardtests.length) {
+                    stopMetrics();
+                    db.disconnect();
+                    done();
+                    return;
+                }
 
-                // Iterate through the remaining backtests.
-                process.stdout.write('Forward testing...\n');
+                // Save results.
+                Forwardtest.collection.insert(forwardtests, metrics.timeCallback('mongo.insert.forwardtests', function(error) {
+                    if (error) {
+                        console.error(error.message || error);
+                    }
 
-                backtests.forEach(function(backtest, index) {
-                    backtestTasks.push(function(taskCallback) {
-                        // Set up a new strategy instance.
-                        var strategy = new strategyFn(argv.symbol, [backtest.configuration]);
+                    stopMetrics();
+                    db.disconnect();
+                    done();
+                }));
+            }));
+        });
+    }
+    catch (error) {
+        cosole.error(error.message || error);
+        process.exit(1);
+    }
+});
 
-                        strategy.setProfitLoss(10000);
+gulp.task('walkforward', function(done) {
+    function showUsageInfo() {
+        console.log('Example usage:\n');
+        console.log('gulp walkforward --symbol AUDJPY --parser metatrader --data ./data/metatrader/three-year/AUDJPY.csv --optimizer Reversals --investment 1000 --profitability 0.7 --in-sample 180 --out-of-sample 30 --database forex-backtesting\n');
+        console.log('Windows start every --step days (the out-of-sample days by default). Backtests over each window\'s in-sample data satisfying --constraints (by default the same ones the forwardtest task uses) are forward tested over its out-of-sample data and saved as validations.\n');
+        console.log('Add --metrics ./data/metrics.log to log timings, throughput and memory use, and --write-concern 0 to not wait for MongoDB to acknowledge inserts of backtests.\n');
+    }
 
-                        // Backtest (forward test).
-                        var results = strategy.backtest(parsedData, investment, profitability);
+    function handleInputError(message) {
+        gutil.log(gutil.colors.red(message));
+        showUsageInfo();
+        process.exit(1);
+    }
 
-                        // Save results.
-                        Forwardtest.create(_.extend(results, {
-                            symbol: argv.symbol,
-                            strategyUuid: backtest.strategyUuid,
-                            configuration: backtest.configuration
-                        }), function() {
-                            process.stdout.cursorTo(18);
-                            process.stdout.write(index + ' of ' + backtestCount + ' completed');
+    var db = require('./db');
+    var dataParsers = require('./src/dataParsers');
+    var optimizers = require('./src/optimizers');
+    var walkForward = require('./src/optimizers/walkForward');
+    var constraints = require('./src/constraints');
+    var investment = 0.0;
+    var profitability = 0.0;
+    var options = {};
 
-                            // Forward test the next backtest.
-                            taskCallback();
-                        });
-                    });
-                });
+    if (!argv.symbol) {
+        handleInputError('No symbol provided');
+    }
 
-                async.series(backtestTasks, function(error) {
-                    process.stdout.cursorTo(18);
-                    process.stdout.write(backtestCount + ' of ' + backtestCount + ' completed\n');
+    if (!dataParsers[argv.parser]) {
+        handleInputError('Invalid data parser');
+    }
 
-                    db.disconnect();
-                    done();
-                });
+    if (!argv.data) {
+        handleInputError('No data file provided');
+    }
+
+    if (!optimizers[argv.optimizer]) {
+        handleInputError('Invalid strategy optimizer');
+    }
+
+    investment = parseFloat(argv.investment)
+    if (!investment) {
+        handleInputError('Invalid investment');
+    }
+
+    profitability = parseFloat(argv.profitability)
+    if (!profitability) {
+        handleInputError('No profitability provided');
+    }
+
+    options.inSample = parseFloat(argv['in-sample']);
+    if (!(options.inSample > 0)) {
+        handleInputError('Invalid number of in-sample days');
+    }
+
+    options.outOfSample = parseFloat(argv['out-of-sample']);
+    if (!(options.outOfSample > 0)) {
+        handleInputError('Invalid number of out-of-sample days');
+    }
+
+    options.step = argv.step !== undefined ? parseFloat(argv.step) : options.outOfSample;
+    if (!(options.step > 0)) {
+        handleInputError('Invalid number of days between windows');
+    }
+
+    if (argv.constraints) {
+        options.constraints = constraints.parse(argv.constraints);
+    }
+
+    if (!argv.database) {
+        handleInputError('No database provided');
+    }
+
+    // Set up database connection.
+    db.initialize(argv.database);
+
+    function configure(optimizer) {
+        if (argv['write-concern'] !== undefined) {
+            optimizer.setWriteConcern(isNaN(argv['write-concern']) ? String(argv['write-concern']) : Number(argv['write-concern']));
+        }
+    }
+
+    startMetrics();
+
+    try {
+        walkForward.run(argv.optimizer, argv.parser, argv.symbol, argv.data, options, investment, profitability, configure, function() {
+            stopMetrics();
+            db.disconnect();
+            done();
+        });
+    }
+    catch (error) {
+        console.error(error.message || error);
+        process.exit(1);
+    }
+});
+
+gulp.task('live', function(done) {
+    function showUsageInfo() {
+        console.log('Example usage:\n');
+        console.log('gulp live --symbol AUDJPY --parser metatrader --data ./data/metatrader/live/AUDJPY.csv --investment 1000 --profitability 0.7 --database forex-backtesting\n');
+        console.log('Bars appended to the --data file are read as they arrive. Use --port 5000 instead to take bars (lines in the parser\'s format) over TCP connections. Backtests satisfying --constraints (by default the same ones the forwardtest task uses) are run forward, and their signals are logged.\n');
+        console.log('Add --metrics ./data/metrics.log to log timings, throughput and memory use.\n');
+    }
+
+    function handleInputError(message) {
+        gutil.log(gutil.colors.red(message));
+        showUsageInfo();
+        process.exit(1);
+    }
+
+    var db = require('./db');
+    var dataParsers = require('./src/dataParsers');
+    var LiveRunner = require('./src/LiveRunner');
+    var Backtest = require('./src/models/Backtest');
+    var optimizerFn = require('./src/optimizers/Reversals');
+    var strategyFn = require('./src/strategies/combined/Reversals');
+    var constraints = require('./src/constraints');
+    var dataParser;
+    var investment = 0.0;
+    var profitability = 0.0;
+    var backtestConstraints = {};
+
+    if (!argv.symbol) {
+        handleInputError('No symbol provided');
+    }
+
+    dataParser = dataParsers[argv.parser]
+    if (!dataParser) {
+        handleInputError('Invalid data parser');
+    }
+
+    if (!argv.data && !argv.port) {
+        handleInputError('No data file or port provided');
+    }
+
+    investment = parseFloat(argv.investment)
+    if (!investment) {
+        handleInputError('Invalid investment');
+    }
+
+    profitability = parseFloat(argv.profitability)
+    if (!profitability) {
+        handleInputError('No profitability provided');
+    }
+
+    if (!argv.database) {
+        handleInputError('No database provided');
+    }
+
+    // Choose backtests the same way the forwardtest task does.
+    backtestConstraints = _.extend({
+        symbol: argv.symbol,
+        inSampleStart: {'$exists': false},
+        pruned: {'$ne': true}
+    }, argv.constraints ? constraints.parse(argv.constraints) : constraints.defaults);
+
+    // Set up database connection.
+    db.initialize(argv.database);
+
+    startMetrics();
+
+    Backtest.find(backtestConstraints, metrics.timeCallback('mongo.find.backtests', function(error, backtests) {
+        var strategies = [];
+        var runner = null;
+        var parseLine = null;
+        var server = null;
+        var stop = null;
+
+        if (error) {
+            console.error(error.message || error);
+        }
+
+        backtests = backtests || [];
+
+        strategies = backtests.map(function(backtest) {
+            var strategy = new strategyFn(argv.symbol, [backtest.configuration]);
+
+            strategy.setProfitLoss(10000);
+
+            return strategy;
+        });
+
+        // Studies start over wherever there is a significant gap in the data, as they do for the forwardtest task.
+        runner = new LiveRunner(argv.symbol, strategyFn, strategies, optimizerFn.studyDefinitions, 600000, investment, profitability, path.join(__dirname, 'data', 'live', argv.symbol));
+        parseLine = dataParser.createLineParser(runner);
+
+        if (runner.restore()) {
+            console.log('Continuing from ' + new Date(runner.getLastTimestamp()));
+        }
+
+        runner.setSignalHandler(function(signal) {
+            console.log(new Date(signal.timestamp) + '\t' + signal.type + ' ' + argv.symbol + ' at ' + signal.price + '\t' + JSON.stringify(signal.configuration));
+        });
+
+        process.stdout.write('Running ' + strategies.length + ' strategies forward...');
+
+        if (argv.data) {
+            // Bars already in the file bring the strategies up to date without reporting signals.
+            stop = LiveRunner.tailFile(argv.data, parseLine, function() {
+                runner.setCaughtUp();
+                process.stdout.write('up to date\n');
+            }, parseFloat(argv['poll-interval']) || 250);
+        }
+        else {
+            runner.setCaughtUp();
+            process.stdout.write('listening on port ' + argv.port + '\n');
+            server = LiveRunner.listen(parseInt(argv.port), parseLine);
+            stop = function() {
+                server.close();
+            };
+        }
+
+        process.on('SIGINT', function() {
+            stop();
+            runner.writeCheckpoint();
+            stopMetrics();
+            db.disconnect();
+            done();
+            process.exit(0);
+        });
+    }));
+});
+
+gulp.task('combine', function(done) {
+    function showUsageInfo() {
+        console.log('Example usage:\n');
+        console.log('gulp combine --symbol AUDJPY --strategy Reversals --database forex-backtesting\n');
+    }
+
+    function handleInputError(message) {
+        gutil.log(gutil.colors.red(message));
+        showUsageInfo();
+        process.exit(1);
+    }
+
+    var db = require('./db');
+    var Forwardtest = require('./src/models/Forwardtest');
+    var Position = require('./src/models/Position');
+    var Combination = require('./src/models/Combination');
+    var positionTester = require('./src/positionTester');
+    var combiner = require('./src/combiner');
+
+    var forwardtestConstraints = {
+        symbol: argv.symbol,
+        //strategyName: argv.strategy,
+        minimumProfitLoss: {'$gte': 0},
+        maximumConsecutiveLosses: {'$lte': 5},
+        winRate: {'$gte': 0.62},
+        tradeCount: {'$gte': 75},
+    };
+
+    // Requirements for combined positions to be an improvement.
+    var combinationRequirements = {
+        minimumImprovement: 1000,
+        minimumWinRate: 0.62,
+        minimumTradeCount: 3000,
+        maximumConsecutiveLosses: 20,
+        minimumProfitLoss: -20000
+    };
+
+    // Find the symbol based on the command line argument.
+    if (!argv.symbol) {
+        handleInputError('No symbol provided');
+    }
+
+    // Find the strategy based on the command line argument.
+    if (!argv.strategy) {
+        handleInputError('Invalid strategy');
+    }
+
+    if (!argv.database) {
+        handleInputError('No database provided');
+    }
+
+    // Set up database connection.
+    db.initialize(argv.database);
+
+    // Find all forward tests for the symbol.
+    Forwardtest.find(forwardtestConstraints, function(error, forwardtests) {
+        // Sort forward tests descending by win rate.
+        forwardtests = _.sortBy(forwardtests, 'winRate').reverse();
+
+        process.stdout.write('Loading positions...');
+
+        // Load the positions for every forward test at once.
+        Position.find({strategyUuid: {'$in': _.pluck(forwardtests, 'strategyUuid')}}, function(error, positions) {
+            var forwardtestCount = forwardtests.length;
+            var combination = null;
+            var showProgress = progress.create(27);
+
+            process.stdout.write(positions.length + ' positions loaded\n');
+            process.stdout.write('Combining configurations...');
+
+            combination = combiner.combine(forwardtests, positions, combinationRequirements, function(index, count, configurationCount, benchmarkProfitLoss) {
+                showProgress(index + ' of ' + count + ' completed (' + configurationCount + ' / $' + benchmarkProfitLoss + ')');
+            });
+
+            // Save the results.
+            Combination.create({
+                symbol: argv.symbol,
+                strategyName: argv.strategy,
+                results: positionTester.test(combination.positions),
+                configurations: combination.configurations,
+                positions: combination.positions
+            }, function() {
+                showProgress(forwardtestCount + ' of ' + forwardtestCount + ' completed\n', true);
+
+                db.disconnect();
+                done();
             });
         });
+    });
+});
+
+gulp.task('bench', function(done) {
+    function showUsageInfo() {
+        console.log('Example usage:\n');
+        console.log('gulp bench --bars 100000 --seed 1 --output ./benchmarks.json\n');
+        console.log('Use --parser metatrader --data ./data/metatrader/AUDJPY.csv to benchmark against recorded data instead of synthetic bars, and --database forex-backtesting to also optimize end to end (backtests are saved under the BENCH symbol and removed afterwards).\n');
+    }
+
+    function handleInputError(message) {
+        gutil.log(gutil.colors.red(message));
+        showUsageInfo();
+        process.exit(1);
+    }
+
+    var fs = require('fs');
+    var db = require('./db');
+    var dataParsers = require('./src/dataParsers');
+    var optimizers = require('./src/optimizers');
+    var ColumnStore = require('./src/ColumnStore');
+    var benchmarks = require('./src/benchmarks');
+
+    var directory = path.join(__dirname, 'data', 'benchmarks');
+    var outputPath = argv.output || path.join(directory, Date.now() + '.json');
+    var options = {
+        bars: parseInt(argv.bars) || 100000,
+        seed: parseInt(argv.seed) || 1,
+        tickBars: parseInt(argv['tick-bars']) || 20000,
+        configurations: parseInt(argv.configurations) || 10,
+        parser: argv.parser,
+        data: argv.data,
+        database: argv.database,
+        optimizer: argv.optimizer || 'Reversals',
+        optimizeConfigurations: parseInt(argv['optimize-configurations']) || 64,
+        investment: parseFloat(argv.investment) || 1000,
+        profitability: parseFloat(argv.profitability) || 0.7,
+        directory: directory
+    };
+
+    if (options.data && !dataParsers[options.parser]) {
+        handleInputError('Invalid data parser');
+    }
+
+    if (!optimizers[options.optimizer]) {
+        handleInputError('Invalid optimizer');
+    }
+
+    ColumnStore.makeDirectory(directory);
+
+    if (options.database) {
+        db.initialize(options.database);
+    }
+
+    try {
+        benchmarks.run(options, function(error, results) {
+            if (error) {
+                console.error(error.message || error);
+                process.exit(1);
+            }
+
+            fs.writeFileSync(outputPath, JSON.stringify(results, null, 4) + '\n');
+            process.stdout.write('Results written to ' + outputPath + '\n');
+
+            if (options.database) {
+                db.disconnect();
+            }
+            done();
+        });
     }
     catch (error) {
-        cosole.error(error.message || error);
+        console.error(error.message || error);
         process.exit(1);
     }
 });
 
-// gulp.task('combine', function(done) {
-//     function showUsageInfo() {
-//         console.log('Example usage:\n');
-//         console.log('gulp combine --symbol AUDJPY --strategy Reversals --investment 1000 --profitability 0.7 --database forex-backtesting\n');
-//     }
-
-//     function handleInputError(message) {
-//         gutil.log(gutil.colors.red(message));
-//         showUsageInfo();
-//         process.exit(1);
-//     }
-
-//     var db = require('./db');
-//     var Forwardtest = require('./src/models/Forwardtest');
-//     var Position = require('./src/models/Position');
-//     var Combination = require('./src/models/Combination');
-//     var positionTester = require('./src/positionTester');
-
-//     var profitability = 0.0;
-
-//     var forwardtestConstraints = {
-//         symbol: argv.symbol,
-//         //strategyName: argv.strategy,
-//         minimumProfitLoss: {'$gte': 0},
-//         maximumConsecutiveLosses: {'$lte': 5},
-//         winRate: {'$gte': 0.62},
-//         tradeCount: {'$gte': 75},
-//     };
-
-//     // Find the symbol based on the command line argument.
-//     if (!argv.symbol) {
-//         handleInputError('No symbol provided');
-//     }
-
-//     // Find the strategy based on the command line argument.
-//     if (!argv.strategy) {
-//         handleInputError('Invalid strategy');
-//     }
-
-//     investment = parseFloat(argv.investment)
-//     if (!investment) {
-//         handleInputError('Invalid investment');
-//     }
-
-//     profitability = parseFloat(argv.profitability)
-//     if (!profitability) {
-//         handleInputError('No profitability provided');
-//     }
-
-//     if (!argv.database) {
-//         handleInputError('No database provided');
-//     }
-
-//     // Set up database connection.
-//     db.initialize(argv.database);
-
-//     // Find all forward tests for the symbol.
-//     Forwardtest.find(forwardtestConstraints, function(error, forwardtests) {
-//         // Sort forward tests descending by profitLoss.
-//         forwardtests = _.sortBy(forwardtests, 'winRate').reverse();
-
-//         // Use the highest profit/loss figure as the benchmark.
-//         var benchmarkProfitLoss = 0;
-//         var optimalConfigurations = [];
-//         var optimalPositions = [];
-//         var percentage = 0.0;
-//         var forwardtestCount = forwardtests.length;
-//         var tasks = [];
-
-//         // Iterate through the remaining forward tests.
-//         process.stdout.write('Combining configurations...');
-
-//         forwardtests.forEach(function(forwardtest, index) {
-//             tasks.push(function(taskCallback) {
-//                 process.stdout.cursorTo(27);
-//                 process.stdout.write(index + ' of ' + forwardtestCount + ' completed (' + optimalConfigurations.length + ' / $' + benchmarkProfitLoss + ')');
-
-//                 // Find all positions for each forward test.
-//                 Position.find({strategyUuid: forwardtest.strategyUuid}, function(error, positions) {
-//                     // Test with the optimal positions combined with the current positions.
-//                     var testPositions = optimalPositions.concat(positions);
-
-//                     // Get the unique set of trades.
-//                     var testPositions = _.uniq(testPositions, function(position) {
-//                         return position.timestamp;
-//                     });
-
-//                     // Sort positions by timestamp.
-//                     testPositions = _.sortBy(testPositions, 'timestamp');
-
-//                     // Determine if all the trades combined results in an improvement.
-//                     var testResults = positionTester.test(testPositions);
-
-//                     // See if the test resulted in an improvement.
-//                     if (testResults.profitLoss >= benchmarkProfitLoss + 1000 && testResults.winRate >= 0.62 && testResults.tradeCount >= 3000 && testResults.maximumConsecutiveLosses <= 20 && testResults.minimumProfitLoss >= -20000) {
-//                         // Use the positions in future tests.
-//                         optimalPositions = testPositions;
-
-//                         // Include the forward test configuration in the list of optimal configurations.
-//                         optimalConfigurations.push(forwardtest.configuration);
-
-//                         // Update the benchmark.
-//                         benchmarkProfitLoss = testResults.profitLoss;
-//                     }
-
-//                     taskCallback(error);
-//                 });
-//             });
-//         });
-
-//         // Execute the tasks, in order.
-//         async.series(tasks, function(error) {
-//             var optimalResults = positionTester.test(optimalPositions);
-
-//             // Save the results.
-//             Combination.create({
-//                 symbol: argv.symbol,
-//                 strategyName: argv.strategy,
-//                 results: optimalResults,
-//                 configurations: optimalConfigurations,
-//                 positions: optimalPositions
-//             }, function() {
-//                 process.stdout.cursorTo(27);
-//                 process.stdout.write(forwardtestCount + ' of ' + forwardtestCount + ' completed\n');
-//                 done();
-//                 process.exit();
-//             });
-//         });
-//     });
-// });
+gulp.task('test', function(done) {
+    var fs = require('fs');
+    var testDirectory = path.join(__dirname, 'test');
+    var caseCount = 0;
+    var failureCount = 0;
+
+    // Each file in the test directory exports its test cases by name. A case fails by throwing.
+    fs.readdirSync(testDirectory).filter(function(fileName) {
+        return path.extname(fileName) === '.js';
+    }).sort().forEach(function(fileName) {
+        var testCases = require(path.join(testDirectory, fileName));
+
+        Object.keys(testCases).forEach(function(caseName) {
+            var name = path.basename(fileName, '.js') + ': ' + caseName;
+
+            caseCount++;
+
+            try {
+                testCases[caseName]();
+                console.log(name + ': ok');
+            }
+            catch (error) {
+                failureCount++;
+                console.log(gutil.colors.red(name + ': ' + (error.message || error)));
+            }
+        });
+    });
+
+    if (failureCount) {
+        gutil.log(gutil.colors.red(failureCount + ' of ' + caseCount + ' tests failed'));
+        process.exit(1);
+    }
+
+    done();
+});
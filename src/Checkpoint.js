@@ -0,0 +1,94 @@
+var fs = require('fs');
+var path = require('path');
+var crypto = require('crypto');
+var ColumnStore = require('./ColumnStore');
+
+// Saves the state of strategies part way through an optimization run, so that an interrupted run can
+// continue from the last completed block rather than from the start. Each fork writes its own file in
+// the checkpoint directory, mapping configuration hashes to the index of the next data point to backtest
+// and the strategy state at that point.
+function Checkpoint(directory) {
+    this.directory = directory;
+}
+
+// Returns a stable hash for a configuration, independent of key order.
+Checkpoint.getConfigurationHash = function(configuration) {
+    return crypto.createHash('md5').update(Checkpoint.canonicalize(configuration)).digest('hex');
+};
+
+// Returns JSON for a value with object keys sorted.
+Checkpoint.canonicalize = function(value) {
+    if (value === null || typeof value !== 'object') {
+        return JSON.stringify(value);
+    }
+
+    if (value instanceof Array) {
+        return '[' + value.map(Checkpoint.canonicalize).join(',') + ']';
+    }
+
+    return '{' + Object.keys(value).sort().filter(function(key) {
+        return value[key] !== undefined;
+    }).map(function(key) {
+        return JSON.stringify(key) + ':' + Checkpoint.canonicalize(value[key]);
+    }).join(',') + '}';
+};
+
+Checkpoint.prototype.getDirectory = function() {
+    return this.directory;
+};
+
+// Returns the most recent checkpointed state for each configuration hash.
+Checkpoint.prototype.load = function() {
+    var self = this;
+    var entries = {};
+
+    if (!fs.existsSync(self.directory)) {
+        return entries;
+    }
+
+    fs.readdirSync(self.directory).forEach(function(fileName) {
+        var fileEntries = null;
+        var configurationHash = '';
+
+        if (path.extname(fileName) !== '.json') {
+            return;
+        }
+
+        fileEntries = JSON.parse(fs.readFileSync(path.join(self.directory, fileName), 'utf8'));
+
+        for (configurationHash in fileEntries) {
+            if (!entries[configurationHash] || fileEntries[configurationHash].index > entries[configurationHash].index) {
+                entries[configurationHash] = fileEntries[configurationHash];
+            }
+        }
+    });
+
+    return entries;
+};
+
+// Writes a checkpoint file, replacing it atomically so that an interruption never leaves it partly written.
+Checkpoint.prototype.write = function(name, entries) {
+    var filePath = path.join(this.directory, name + '.json');
+
+    ColumnStore.makeDirectory(this.directory);
+
+    fs.writeFileSync(filePath + '.tmp', JSON.stringify(entries));
+    fs.renameSync(filePath + '.tmp', filePath);
+};
+
+// Removes all checkpoint files, once a run has completed.
+Checkpoint.prototype.clear = function() {
+    var self = this;
+
+    if (!fs.existsSync(self.directory)) {
+        return;
+    }
+
+    fs.readdirSync(self.directory).forEach(function(fileName) {
+        fs.unlinkSync(path.join(self.directory, fileName));
+    });
+
+    fs.rmdirSync(self.directory);
+};
+
+module.exports = Checkpoint;
@@ -0,0 +1,393 @@
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var buffers = require('./buffers');
+
+// Number of bytes used to store each value.
+var valueSize = 8;
+
+// Whether column files can be read into and written from typed arrays' own memory. Buffers can share
+// memory with typed arrays in newer versions of Node.js, and values then need no conversion if the host
+// stores doubles little-endian like column files do. Otherwise values are converted one at a time.
+var sharesMemory = buffers.canShareMemory && os.endianness() === 'LE';
+
+function makeDirectory(directory) {
+    if (fs.existsSync(directory)) {
+        return;
+    }
+
+    // Create parent directories first (fs.mkdirSync is not recursive).
+    makeDirectory(path.dirname(directory));
+    fs.mkdirSync(directory);
+}
+
+// Returns a buffer of the first count values as little-endian doubles.
+function toBuffer(values, count) {
+    var buffer = null;
+    var i = 0;
+
+    if (sharesMemory && values instanceof Float64Array) {
+        return Buffer.from(values.buffer, values.byteOffset, count * valueSize);
+    }
+
+    buffer = buffers.alloc(count * valueSize);
+
+    for (i = 0; i < count; i++) {
+        buffer.writeDoubleLE(values[i], i * valueSize);
+    }
+
+    return buffer;
+}
+
+// Reads from a file into the whole of a buffer, returning the number of bytes read, which is less than
+// the buffer's length only if the file ends first.
+function readFully(fileDescriptor, buffer, position) {
+    var bytesRead = 0;
+    var totalBytesRead = 0;
+
+    while (totalBytesRead < buffer.length) {
+        bytesRead = fs.readSync(fileDescriptor, buffer, totalBytesRead, buffer.length - totalBytesRead, position + totalBytesRead);
+
+        if (!bytesRead) {
+            break;
+        }
+
+        totalBytesRead += bytesRead;
+    }
+
+    return totalBytesRead;
+}
+
+function ColumnStore(directory) {
+    this.directory = directory;
+    this.manifest = null;
+    this.fileDescriptors = {};
+
+    // Columns being written, which are only added to the manifest once complete.
+    this.pendingColumns = null;
+}
+
+ColumnStore.makeDirectory = makeDirectory;
+
+// Columns every prepared data point has, regardless of the studies used.
+ColumnStore.baseColumns = ['timestamp', 'volume', 'open', 'high', 'low', 'close'];
+
+// Number of data points to read from disk at a time when iterating.
+ColumnStore.chunkSize = 10000;
+
+ColumnStore.prototype.getDirectory = function() {
+    return this.directory;
+};
+
+ColumnStore.prototype.getManifestPath = function() {
+    return path.join(this.directory, 'manifest.json');
+};
+
+ColumnStore.prototype.getColumnPath = function(columnName) {
+    return path.join(this.directory, columnName + '.f64');
+};
+
+ColumnStore.prototype.getPendingColumnPath = function(columnName) {
+    return this.getColumnPath(columnName) + '.pending';
+};
+
+ColumnStore.prototype.load = function() {
+    if (!this.manifest) {
+        if (!fs.existsSync(this.getManifestPath())) {
+            return null;
+        }
+        this.manifest = JSON.parse(fs.readFileSync(this.getManifestPath(), 'utf8'));
+    }
+
+    return this.manifest;
+};
+
+ColumnStore.prototype.saveManifest = function() {
+    fs.writeFileSync(this.getManifestPath(), JSON.stringify(this.manifest));
+};
+
+// Replaces the manifest, for example with one describing column files copied from another store.
+ColumnStore.prototype.setManifest = function(manifest) {
+    this.manifest = manifest;
+    this.saveManifest();
+};
+
+ColumnStore.prototype.isComplete = function() {
+    var manifest = this.load();
+
+    return !!(manifest && manifest.complete);
+};
+
+ColumnStore.prototype.getCount = function() {
+    var manifest = this.load();
+
+    return manifest ? manifest.count : 0;
+};
+
+ColumnStore.prototype.getColumnNames = function() {
+    var manifest = this.load();
+
+    return manifest ? manifest.columns.slice() : [];
+};
+
+ColumnStore.prototype.hasColumn = function(columnName) {
+    return this.getColumnNames().indexOf(columnName) > -1;
+};
+
+ColumnStore.prototype.create = function(columnNames) {
+    var self = this;
+
+    self.close();
+    makeDirectory(self.directory);
+
+    // Start each column file over.
+    columnNames.forEach(function(columnName) {
+        fs.writeFileSync(self.getColumnPath(columnName), buffers.alloc(0));
+    });
+
+    self.manifest = {
+        columns: columnNames.slice(),
+        count: 0,
+        complete: false,
+        studies: {}
+    };
+    self.saveManifest();
+};
+
+ColumnStore.prototype.markComplete = function() {
+    this.load().complete = true;
+    this.saveManifest();
+};
+
+ColumnStore.prototype.append = function(columns) {
+    var self = this;
+    var manifest = self.load();
+    var count = 0;
+
+    if (!manifest) {
+        throw 'ColumnStore must be created before data is appended.';
+    }
+
+    count = columns.timestamp.length;
+    if (!count) {
+        return;
+    }
+
+    // Write the values for each column to the end of the column's file.
+    manifest.columns.forEach(function(columnName) {
+        var values = columns[columnName];
+
+        if (!values || values.length !== count) {
+            throw 'Invalid values provided for column ' + columnName + '.';
+        }
+
+        fs.appendFileSync(self.getColumnPath(columnName), toBuffer(values, count));
+    });
+
+    manifest.count += count;
+    self.saveManifest();
+};
+
+// Starts writing new columns (or replacements for existing ones) a batch of values at a time. The columns
+// are written to separate files, and only replace any existing columns once committed.
+ColumnStore.prototype.beginColumns = function(columnNames) {
+    var self = this;
+
+    makeDirectory(self.directory);
+
+    columnNames.forEach(function(columnName) {
+        fs.writeFileSync(self.getPendingColumnPath(columnName), buffers.alloc(0));
+    });
+
+    self.pendingColumns = {
+        columns: columnNames.slice(),
+        count: 0
+    };
+};
+
+// Appends the next values for each column being written.
+ColumnStore.prototype.appendColumns = function(columns) {
+    var self = this;
+    var pendingColumns = self.pendingColumns;
+    var count = -1;
+
+    if (!pendingColumns) {
+        throw 'Columns must be begun before data is appended.';
+    }
+
+    pendingColumns.columns.forEach(function(columnName) {
+        var values = columns[columnName];
+
+        if (!values || (count > -1 && values.length !== count)) {
+            throw 'Invalid values provided for column ' + columnName + '.';
+        }
+
+        count = values.length;
+
+        fs.appendFileSync(self.getPendingColumnPath(columnName), toBuffer(values, count));
+    });
+
+    pendingColumns.count += Math.max(count, 0);
+};
+
+// Adds the columns being written to the store, once they have one value per data point. studyKeys
+// optionally maps each column name to the key of the study that produced it.
+ColumnStore.prototype.commitColumns = function(studyKeys) {
+    var self = this;
+    var manifest = self.load();
+    var pendingColumns = self.pendingColumns;
+
+    if (!pendingColumns) {
+        return;
+    }
+
+    if (pendingColumns.columns.length && pendingColumns.count !== manifest.count) {
+        throw 'Invalid number of values written for columns.';
+    }
+
+    manifest.studies = manifest.studies || {};
+
+    pendingColumns.columns.forEach(function(columnName) {
+        // Do not keep reading from a replaced file.
+        if (self.fileDescriptors[columnName]) {
+            fs.closeSync(self.fileDescriptors[columnName]);
+            delete self.fileDescriptors[columnName];
+        }
+
+        fs.renameSync(self.getPendingColumnPath(columnName), self.getColumnPath(columnName));
+    });
+
+    // Only record the columns once all of their data has been written.
+    pendingColumns.columns.forEach(function(columnName) {
+        if (manifest.columns.indexOf(columnName) === -1) {
+            manifest.columns.push(columnName);
+        }
+
+        if (studyKeys && studyKeys[columnName]) {
+            manifest.studies[columnName] = studyKeys[columnName];
+        }
+        else {
+            delete manifest.studies[columnName];
+        }
+    });
+    self.saveManifest();
+
+    self.pendingColumns = null;
+};
+
+// Writes complete columns (one value per data point), replacing any existing columns with the same names.
+// studyKeys optionally maps each column name to the key of the study that produced it.
+ColumnStore.prototype.writeColumns = function(columns, studyKeys) {
+    var manifest = this.load();
+
+    if (!manifest || !manifest.complete) {
+        throw 'ColumnStore must be complete before columns are added.';
+    }
+
+    this.beginColumns(Object.keys(columns));
+    this.appendColumns(columns);
+    this.commitColumns(studyKeys);
+};
+
+// Returns the key of the study that produced a column, if any.
+ColumnStore.prototype.getStudyKey = function(columnName) {
+    var manifest = this.load();
+
+    return manifest && manifest.studies ? manifest.studies[columnName] : undefined;
+};
+
+ColumnStore.prototype.getFileDescriptor = function(columnName) {
+    if (!this.fileDescriptors[columnName]) {
+        this.fileDescriptors[columnName] = fs.openSync(this.getColumnPath(columnName), 'r');
+    }
+
+    return this.fileDescriptors[columnName];
+};
+
+ColumnStore.prototype.readColumn = function(columnName, start, count) {
+    var values;
+    var buffer;
+    var bytesRead = 0;
+    var i = 0;
+
+    // Do not read past the end of the data.
+    count = Math.max(Math.min(count, this.getCount() - start), 0);
+
+    values = new Float64Array(count);
+
+    if (!count) {
+        return values;
+    }
+
+    // Read straight into the values, when possible. Workers reading the same blocks of a column share
+    // the file's pages in the operating system's cache, and only copy the values they read.
+    buffer = sharesMemory ? Buffer.from(values.buffer) : buffers.alloc(count * valueSize);
+    bytesRead = readFully(this.getFileDescriptor(columnName), buffer, start * valueSize);
+
+    // A column file cut short would otherwise leave zeros that look like real values.
+    if (bytesRead !== count * valueSize) {
+        throw 'Column ' + columnName + ' in ' + this.directory + ' has fewer values than the manifest says it has.';
+    }
+
+    if (sharesMemory) {
+        return values;
+    }
+
+    for (i = 0; i < count; i++) {
+        values[i] = buffer.readDoubleLE(i * valueSize);
+    }
+
+    return values;
+};
+
+ColumnStore.prototype.readColumns = function(columnNames, start, count) {
+    var self = this;
+    var columns = {};
+
+    columnNames = columnNames || self.getColumnNames();
+
+    columnNames.forEach(function(columnName) {
+        columns[columnName] = self.readColumn(columnName, start, count);
+    });
+
+    return columns;
+};
+
+ColumnStore.prototype.readDataPoints = function(start, count) {
+    var columnNames = this.getColumnNames();
+    var columnCount = columnNames.length;
+    var columns = this.readColumns(columnNames, start, count);
+    var dataPoints = [];
+    var dataPoint;
+    var value = 0.0;
+    var i = 0;
+    var j = 0;
+
+    count = columns.timestamp.length;
+
+    for (i = 0; i < count; i++) {
+        dataPoint = {};
+
+        for (j = 0; j < columnCount; j++) {
+            value = columns[columnNames[j]][i];
+
+            // Missing study values are represented by empty strings, as they are when prepared.
+            dataPoint[columnNames[j]] = value === value ? value : '';
+        }
+
+        dataPoints[i] = dataPoint;
+    }
+
+    return dataPoints;
+};
+
+ColumnStore.prototype.close = function() {
+    var columnName = '';
+
+    for (columnName in this.fileDescriptors) {
+        fs.closeSync(this.fileDescriptors[columnName]);
+    }
+    this.fileDescriptors = {};
+};
+
+module.exports = ColumnStore;
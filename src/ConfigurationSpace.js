@@ -0,0 +1,138 @@
+var Checkpoint = require('./Checkpoint');
+
+// The cartesian product of a set of configuration options, without building it. Each configuration has an
+// index, and its option values are decoded from the index as mixed-radix digits (one digit per option,
+// with the last option varying fastest), so any configuration or range of configurations can be produced
+// on demand.
+function ConfigurationSpace(options) {
+    var self = this;
+    var i = 0;
+
+    self.options = options;
+    self.keys = Object.keys(options);
+    self.strides = [];
+    self.count = self.keys.length ? 1 : 0;
+
+    // The stride for each option is the number of configurations before its value changes.
+    for (i = self.keys.length - 1; i >= 0; i--) {
+        self.strides[i] = self.count;
+        self.count *= options[self.keys[i]].length;
+    }
+
+    // Positions of each option's values, by their JSON, for finding configurations' indexes. Built when
+    // first needed.
+    self.valueIndexes = null;
+}
+
+ConfigurationSpace.prototype.getOptions = function() {
+    return this.options;
+};
+
+ConfigurationSpace.prototype.getCount = function() {
+    return this.count;
+};
+
+// Returns the configuration with the given index.
+ConfigurationSpace.prototype.get = function(index) {
+    var configuration = {};
+    var values;
+    var value;
+    var i = 0;
+
+    if (index < 0 || index >= this.count) {
+        throw 'Configuration index ' + index + ' out of range.';
+    }
+
+    for (i = 0; i < this.keys.length; i++) {
+        values = this.options[this.keys[i]];
+        value = values[Math.floor(index / this.strides[i]) % values.length];
+
+        // Copy object values so that configurations do not share them.
+        configuration[this.keys[i]] = value !== null && typeof value === 'object' ? JSON.parse(JSON.stringify(value)) : value;
+    }
+
+    return configuration;
+};
+
+// Returns the index of a configuration, or -1 if it is not in the space.
+ConfigurationSpace.prototype.indexOf = function(configuration) {
+    var self = this;
+    var index = 0;
+    var valueIndex;
+    var key = '';
+    var i = 0;
+
+    if (!self.valueIndexes) {
+        self.valueIndexes = self.keys.map(function(key) {
+            var valueIndexes = {};
+
+            self.options[key].forEach(function(value, valueIndex) {
+                valueIndexes[Checkpoint.canonicalize(value)] = valueIndex;
+            });
+
+            return valueIndexes;
+        });
+    }
+
+    // Configurations with other options are not in the space.
+    for (key in configuration) {
+        if (configuration[key] !== undefined && !self.options.hasOwnProperty(key)) {
+            return -1;
+        }
+    }
+
+    for (i = 0; i < self.keys.length; i++) {
+        valueIndex = self.valueIndexes[i][Checkpoint.canonicalize(configuration[self.keys[i]])];
+
+        if (valueIndex === undefined) {
+            return -1;
+        }
+
+        index += valueIndex * self.strides[i];
+    }
+
+    return index;
+};
+
+// Returns [start, end) index ranges for every configuration except those with the given indexes.
+ConfigurationSpace.prototype.getRangesExcluding = function(indexes) {
+    var ranges = [];
+    var start = 0;
+
+    indexes.slice().sort(function(a, b) {
+        return a - b;
+    }).forEach(function(index) {
+        if (index > start) {
+            ranges.push([start, index]);
+        }
+        start = Math.max(start, index + 1);
+    });
+
+    if (start < this.count) {
+        ranges.push([start, this.count]);
+    }
+
+    return ranges;
+};
+
+// Calls fn(configuration, index) for each configuration in a list of [start, end) index ranges.
+ConfigurationSpace.prototype.forEachInRanges = function(ranges, fn) {
+    var self = this;
+
+    ranges.forEach(function(range) {
+        var index = 0;
+
+        for (index = range[0]; index < range[1]; index++) {
+            fn(self.get(index), index);
+        }
+    });
+};
+
+// Returns the number of indexes in a list of ranges.
+ConfigurationSpace.countRanges = function(ranges) {
+    return ranges.reduce(function(count, range) {
+        return count + range[1] - range[0];
+    }, 0);
+};
+
+module.exports = ConfigurationSpace;
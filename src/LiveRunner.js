@@ -0,0 +1,215 @@
+var fs = require('fs');
+var net = require('net');
+var StudyTicker = require('./StudyTicker');
+var Checkpoint = require('./Checkpoint');
+var scanner = require('./dataParsers/scanner');
+var metrics = require('./metrics');
+var buffers = require('./buffers');
+
+// Number of bytes to read from a tailed file at a time.
+var readSize = 1024 * 1024;
+
+// Runs combined strategies forward over data as it arrives, one bar at a time. Each bar goes through the
+// studies (see StudyTicker) and then every strategy, so signals for the next bar are known as soon as a
+// bar closes. Study and strategy state is checkpointed after each live bar, so a restart picks up from the
+// last bar processed rather than going over the history again.
+//
+// Bars are pushed the way parsers push them onto columns, so a runner can be given to a parser's
+// createLineParser() directly.
+function LiveRunner(symbol, strategyFn, strategies, studyDefinitions, gapThreshold, investment, profitability, checkpointDirectory) {
+    this.symbol = symbol;
+    this.strategyFn = strategyFn;
+    this.strategies = strategies;
+    this.profitability = profitability;
+    this.ticker = new StudyTicker(studyDefinitions, gapThreshold);
+    this.cursor = strategyFn.startAll(strategies, investment);
+    this.checkpoint = new Checkpoint(checkpointDirectory);
+    this.lastTimestamp = -Infinity;
+    this.caughtUp = false;
+    this.signalHandler = null;
+}
+
+// Sets a function to call with each signal found once caught up, as {timestamp, price, type,
+// configuration}. Positions for signals open at the close of the bar the signal is found on.
+LiveRunner.prototype.setSignalHandler = function(signalHandler) {
+    this.signalHandler = signalHandler;
+};
+
+LiveRunner.prototype.getStrategies = function() {
+    return this.strategies;
+};
+
+LiveRunner.prototype.getLastTimestamp = function() {
+    return this.lastTimestamp;
+};
+
+// Marks the end of bars that were already available, from which point signals are reported and state is
+// checkpointed after every bar.
+LiveRunner.prototype.setCaughtUp = function() {
+    if (!this.caughtUp) {
+        this.caughtUp = true;
+        this.writeCheckpoint();
+    }
+};
+
+// Restores state from the checkpoint, if there is one, returning whether there was.
+LiveRunner.prototype.restore = function() {
+    var self = this;
+    var entries = self.checkpoint.load();
+
+    if (!entries.studies) {
+        return false;
+    }
+
+    self.ticker.setState(entries.studies.state);
+    self.cursor.previousDataPoint = entries.cursor.state.previousDataPoint;
+    self.cursor.previousDay = entries.cursor.state.previousDay;
+    self.lastTimestamp = entries.cursor.index;
+
+    // Strategies not running when the checkpoint was written start from here.
+    self.strategies.forEach(function(strategy) {
+        var entry = entries[Checkpoint.getConfigurationHash(strategy.getConfigurations())];
+
+        if (entry) {
+            strategy.setState(entry.state);
+        }
+    });
+
+    return true;
+};
+
+// Saves study and strategy state. Entries are indexed by the timestamp of the last bar processed.
+LiveRunner.prototype.writeCheckpoint = function() {
+    var self = this;
+    var index = self.lastTimestamp;
+    var entries = {};
+    var stopTimer = null;
+
+    // There is nothing to save before the first bar.
+    if (index === -Infinity) {
+        return;
+    }
+
+    stopTimer = metrics.time('writeCheckpoint');
+
+    entries.studies = {
+        index: index,
+        state: self.ticker.getState()
+    };
+    entries.cursor = {
+        index: index,
+        state: {
+            previousDataPoint: self.cursor.previousDataPoint,
+            previousDay: self.cursor.previousDay
+        }
+    };
+
+    self.strategies.forEach(function(strategy) {
+        entries[Checkpoint.getConfigurationHash(strategy.getConfigurations())] = {
+            index: index,
+            state: strategy.getState()
+        };
+    });
+
+    self.checkpoint.write(self.symbol, entries);
+    stopTimer();
+};
+
+// Processes the next bar. Bars at or before the last one processed (such as those before a checkpoint,
+// when a file is read again from the start) are skipped.
+LiveRunner.prototype.push = function(timestamp, volume, open, high, low, close) {
+    var self = this;
+    var start = Date.now();
+    var dataPoint = null;
+
+    if (!(timestamp > self.lastTimestamp)) {
+        return;
+    }
+
+    dataPoint = self.ticker.tick({
+        timestamp: timestamp,
+        volume: volume,
+        open: open,
+        high: high,
+        low: low,
+        close: close
+    });
+
+    // There will always be another bar for live data.
+    self.strategyFn.backtestAllDataPoint(self.strategies, dataPoint, self.cursor, true, self.profitability);
+    self.lastTimestamp = timestamp;
+
+    metrics.increment('liveBars', 1);
+
+    if (!self.caughtUp) {
+        return;
+    }
+
+    metrics.recordLatency('liveBar', Date.now() - start);
+
+    if (self.signalHandler) {
+        self.strategies.forEach(function(strategy) {
+            if (strategy.putNextTick) {
+                self.signalHandler({timestamp: timestamp, price: close, type: 'PUT', configuration: strategy.getConfigurations()[0]});
+            }
+            if (strategy.callNextTick) {
+                self.signalHandler({timestamp: timestamp, price: close, type: 'CALL', configuration: strategy.getConfigurations()[0]});
+            }
+        });
+    }
+
+    self.writeCheckpoint();
+};
+
+// Reads lines from a file as it is appended to, calling onLine as scanner.scan() does. The lines already
+// in the file are read first, then onCaughtUp is called, then the file is checked every pollInterval
+// milliseconds. Returns a function that stops tailing.
+LiveRunner.tailFile = function(filePath, onLine, onCaughtUp, pollInterval) {
+    var fileDescriptor = fs.openSync(filePath, 'r');
+    var lineScanner = new scanner.LineScanner(onLine, 0);
+    var buffer = buffers.alloc(readSize);
+    var position = 0;
+    var timer = null;
+
+    function readAppended() {
+        var bytesRead = 0;
+
+        while ((bytesRead = fs.readSync(fileDescriptor, buffer, 0, readSize, position)) > 0) {
+            position += bytesRead;
+            lineScanner.write(buffer.slice(0, bytesRead));
+        }
+    }
+
+    readAppended();
+    onCaughtUp();
+
+    timer = setInterval(readAppended, pollInterval);
+
+    return function() {
+        clearInterval(timer);
+        fs.closeSync(fileDescriptor);
+    };
+};
+
+// Accepts connections on a port, calling onLine as scanner.scan() does for the lines sent over each.
+// Returns the server.
+LiveRunner.listen = function(port, onLine) {
+    var server = net.createServer(function(socket) {
+        // Data sent over a connection has no header line.
+        var lineScanner = new scanner.LineScanner(onLine, 1);
+
+        socket.on('data', function(data) {
+            lineScanner.write(data);
+        });
+
+        socket.on('error', function(error) {
+            console.error(error.message || error);
+        });
+    });
+
+    server.listen(port);
+
+    return server;
+};
+
+module.exports = LiveRunner;
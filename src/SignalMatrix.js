@@ -0,0 +1,202 @@
+// Evaluates trading conditions over a block of prepared data as bitsets (one bit per data point, packed
+// into 32-bit words). Each distinct condition is evaluated once per block and shared by every strategy
+// that uses it, so a strategy's signals reduce to ANDing words together.
+//
+// A condition is an object with a unique key, the names of the columns it reads, and a test function
+// taking the columns and a data point index.
+
+function SignalMatrix(columns, count) {
+    this.columns = columns;
+    this.count = count;
+    this.wordCount = Math.ceil(count / 32);
+    this.bitsets = {};
+}
+
+SignalMatrix.prototype.getCount = function() {
+    return this.count;
+};
+
+SignalMatrix.prototype.getColumns = function() {
+    return this.columns;
+};
+
+SignalMatrix.prototype.getWordCount = function() {
+    return this.wordCount;
+};
+
+// Returns the bitset for a condition, evaluating it if no other strategy has yet.
+SignalMatrix.prototype.getBitset = function(condition) {
+    var bitset = this.bitsets[condition.key];
+    var columns = this.columns;
+    var test = condition.test;
+    var i = 0;
+
+    if (bitset) {
+        return bitset;
+    }
+
+    bitset = new Uint32Array(this.wordCount);
+
+    for (i = 0; i < this.count; i++) {
+        if (test(columns, i)) {
+            bitset[i >>> 5] |= 1 << (i & 31);
+        }
+    }
+
+    this.bitsets[condition.key] = bitset;
+
+    return bitset;
+};
+
+// ANDs the bitsets for a list of conditions together into target.
+SignalMatrix.prototype.combine = function(conditions, target) {
+    var bitset;
+    var i = 0;
+    var j = 0;
+
+    for (j = 0; j < this.wordCount; j++) {
+        target[j] = 0xffffffff;
+    }
+
+    // Clear the bits beyond the end of the data.
+    if (this.count & 31) {
+        target[this.wordCount - 1] = (1 << (this.count & 31)) - 1;
+    }
+
+    for (i = 0; i < conditions.length; i++) {
+        bitset = this.getBitset(conditions[i]);
+
+        for (j = 0; j < this.wordCount; j++) {
+            target[j] &= bitset[j];
+        }
+    }
+
+    return target;
+};
+
+SignalMatrix.isSet = function(bitset, index) {
+    return (bitset[index >>> 5] & (1 << (index & 31))) !== 0;
+};
+
+// Returns the index of the first bit set in either bitset at or after start, or -1 if there is none.
+SignalMatrix.findNext = function(first, second, start, count) {
+    var wordIndex = start >>> 5;
+    var wordCount = Math.ceil(count / 32);
+    var word = (first[wordIndex] | second[wordIndex]) & (0xffffffff << (start & 31));
+    var index = 0;
+
+    while (!word) {
+        if (++wordIndex >= wordCount) {
+            return -1;
+        }
+        word = first[wordIndex] | second[wordIndex];
+    }
+
+    // Find the lowest set bit.
+    index = (wordIndex << 5) + (31 - Math.clz32(word & -word));
+
+    return index < count ? index : -1;
+};
+
+// Builds columns from data points, for blocks that include the data points themselves. Missing values
+// become NaN.
+SignalMatrix.buildColumns = function(dataPoints, columnNames) {
+    var columns = {};
+    var count = dataPoints.length;
+
+    columnNames.forEach(function(columnName) {
+        var values = new Float64Array(count);
+        var value;
+        var i = 0;
+
+        for (i = 0; i < count; i++) {
+            value = dataPoints[i][columnName];
+            values[i] = typeof value === 'number' ? value : NaN;
+        }
+
+        columns[columnName] = values;
+    });
+
+    return columns;
+};
+
+// Common conditions.
+SignalMatrix.conditions = {
+    // Both values are available and the first is not below the second.
+    notBelow: function(firstColumnName, secondColumnName) {
+        return {
+            key: 'notBelow:' + firstColumnName + ':' + secondColumnName,
+            columns: [firstColumnName, secondColumnName],
+            test: function(columns, index) {
+                var first = columns[firstColumnName][index];
+                var second = columns[secondColumnName][index];
+
+                return !!first && !!second && !(first < second);
+            }
+        };
+    },
+
+    // Both values are available and the first is not above the second.
+    notAbove: function(firstColumnName, secondColumnName) {
+        return {
+            key: 'notAbove:' + firstColumnName + ':' + secondColumnName,
+            columns: [firstColumnName, secondColumnName],
+            test: function(columns, index) {
+                var first = columns[firstColumnName][index];
+                var second = columns[secondColumnName][index];
+
+                return !!first && !!second && !(first > second);
+            }
+        };
+    },
+
+    // The value is available and above the threshold.
+    above: function(columnName, threshold) {
+        return {
+            key: 'above:' + columnName + ':' + threshold,
+            columns: [columnName],
+            test: function(columns, index) {
+                return columns[columnName][index] > threshold;
+            }
+        };
+    },
+
+    // The value is available and below the threshold.
+    below: function(columnName, threshold) {
+        return {
+            key: 'below:' + columnName + ':' + threshold,
+            columns: [columnName],
+            test: function(columns, index) {
+                return columns[columnName][index] < threshold;
+            }
+        };
+    },
+
+    // Both bounds are available and the high price breached the upper bound.
+    breachesUpper: function(upperColumnName, lowerColumnName) {
+        return {
+            key: 'breachesUpper:' + upperColumnName + ':' + lowerColumnName,
+            columns: ['high', upperColumnName, lowerColumnName],
+            test: function(columns, index) {
+                var upper = columns[upperColumnName][index];
+
+                return !!upper && !!columns[lowerColumnName][index] && columns.high[index] > upper;
+            }
+        };
+    },
+
+    // Both bounds are available and the low price breached the lower bound.
+    breachesLower: function(upperColumnName, lowerColumnName) {
+        return {
+            key: 'breachesLower:' + upperColumnName + ':' + lowerColumnName,
+            columns: ['low', upperColumnName, lowerColumnName],
+            test: function(columns, index) {
+                var lower = columns[lowerColumnName][index];
+
+                return !!lower && !!columns[upperColumnName][index] && columns.low[index] < lower;
+            }
+        };
+    }
+};
+
+module.exports = SignalMatrix;
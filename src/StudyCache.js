@@ -0,0 +1,289 @@
+var fs = require('fs');
+var path = require('path');
+var crypto = require('crypto');
+var ColumnStore = require('./ColumnStore');
+var studyRunner = require('./studyRunner');
+var StudyPipeline = require('./StudyPipeline');
+var timeframes = require('./timeframes');
+var metrics = require('./metrics');
+var buffers = require('./buffers');
+
+// Number of bytes to read at a time when hashing data files.
+var hashBufferSize = 1024 * 1024;
+
+// Caches prepared study data for a data file. Data is stored under
+// ./data/prepared/<symbol>/<data file hash>_<gap threshold>/, and each study output column records the
+// key (study class and inputs) of the study that produced it, so that only missing studies are computed.
+// Bars for higher timeframes, and their study outputs, are cached under timeframes/<minutes>m/ within it.
+function StudyCache(symbol, dataFilePath, gapThreshold) {
+    this.symbol = symbol;
+    this.dataFilePath = dataFilePath;
+    this.gapThreshold = gapThreshold;
+    this.dataFileHash = StudyCache.hashFile(dataFilePath);
+    this.store = new ColumnStore(path.join(__dirname, '..', 'data', 'prepared', symbol, this.dataFileHash + '_' + gapThreshold));
+}
+
+StudyCache.hashFile = function(filePath) {
+    var hash = crypto.createHash('md5');
+    var buffer = buffers.alloc(hashBufferSize);
+    var fileDescriptor = 0;
+    var bytesRead = 0;
+
+    if (!filePath) {
+        throw 'No data file provided to study cache.';
+    }
+
+    fileDescriptor = fs.openSync(filePath, 'r');
+
+    while ((bytesRead = fs.readSync(fileDescriptor, buffer, 0, hashBufferSize, null)) > 0) {
+        hash.update(buffer.slice(0, bytesRead));
+    }
+
+    fs.closeSync(fileDescriptor);
+
+    return hash.digest('hex');
+};
+
+StudyCache.prototype.getStore = function() {
+    return this.store;
+};
+
+// Returns the study definitions that have output columns not yet in a store.
+function getMissingDefinitions(store, studyDefinitions) {
+    return studyDefinitions.filter(function(studyDefinition) {
+        var studyKey = studyRunner.getStudyKey(studyDefinition);
+        var outputKey = '';
+        var columnName = '';
+
+        for (outputKey in studyDefinition.outputMap) {
+            columnName = studyDefinition.outputMap[outputKey];
+
+            if (!store.hasColumn(columnName) || store.getStudyKey(columnName) !== studyKey) {
+                return true;
+            }
+        }
+
+        return false;
+    });
+}
+
+// Maps each output column of a study graph to the key of the study that produces it.
+function getStudyKeys(studyGraph) {
+    var studyKeys = {};
+
+    studyGraph.forEach(function(node) {
+        node.outputMaps.forEach(function(outputMap) {
+            var outputKey = '';
+
+            for (outputKey in outputMap) {
+                studyKeys[outputMap[outputKey]] = node.key;
+            }
+        });
+    });
+
+    return studyKeys;
+}
+
+// Returns the study definitions that have output columns not yet in the cache.
+StudyCache.prototype.getMissingDefinitions = function(studyDefinitions) {
+    return getMissingDefinitions(this.store, studyDefinitions);
+};
+
+// Returns the store for bars of a higher timeframe, which is kept alongside the prepared data.
+StudyCache.prototype.getTimeframeStore = function(timeframe) {
+    return new ColumnStore(path.join(this.store.getDirectory(), 'timeframes', timeframe + 'm'));
+};
+
+// Adds study columns for higher timeframes to the (complete) prepared data. Bars for each timeframe are
+// built once from the prepared data and cached along with their study outputs, which are then aligned
+// onto the prepared data without look-ahead (see timeframes.js).
+StudyCache.prototype.prepareTimeframes = function(studyDefinitions) {
+    var self = this;
+    var store = self.store;
+    var timeframeList = [];
+
+    studyDefinitions.forEach(function(studyDefinition) {
+        var timeframe = timeframes.getTimeframe(studyDefinition);
+
+        if (timeframeList.indexOf(timeframe) === -1) {
+            timeframeList.push(timeframe);
+        }
+    });
+
+    timeframeList.forEach(function(timeframe) {
+        var timeframeStore = self.getTimeframeStore(timeframe);
+        var gapThreshold = timeframes.getGapThreshold(self.gapThreshold, timeframe);
+        var timeframeDefinitions = studyDefinitions.filter(function(studyDefinition) {
+            return timeframes.getTimeframe(studyDefinition) === timeframe;
+        });
+        var studyGraph = null;
+        var studyKeys = {};
+        var pipeline = null;
+        var stopTimer = metrics.time('prepareTimeframes');
+        var start = 0;
+
+        if (!timeframeStore.isComplete()) {
+            timeframes.resample(store, timeframeStore, timeframe);
+        }
+
+        // Compute studies missing from the timeframe's cache over its bars.
+        studyGraph = studyRunner.buildGraph(getMissingDefinitions(timeframeStore, timeframeDefinitions));
+
+        if (studyGraph.length) {
+            studyKeys = getStudyKeys(studyGraph);
+            timeframeStore.beginColumns(Object.keys(studyKeys));
+
+            pipeline = new StudyPipeline(studyGraph, gapThreshold, function(columns, outputs) {
+                timeframeStore.appendColumns(outputs);
+            });
+
+            for (start = 0; start < timeframeStore.getCount(); start += ColumnStore.chunkSize) {
+                pipeline.push(timeframeStore.readColumns(ColumnStore.baseColumns, start, ColumnStore.chunkSize));
+            }
+
+            pipeline.end();
+            timeframeStore.commitColumns(studyKeys);
+        }
+
+        // Align every output for the timeframe onto the prepared data.
+        studyKeys = getStudyKeys(studyRunner.buildGraph(timeframeDefinitions));
+
+        store.beginColumns(Object.keys(studyKeys));
+        timeframes.align(timeframeStore, Object.keys(studyKeys), gapThreshold, store.getCount(), function(columns) {
+            store.appendColumns(columns);
+        });
+        store.commitColumns(studyKeys);
+
+        timeframeStore.close();
+        stopTimer();
+    });
+};
+
+// Ensures the cache has data for every study definition. Price data is streamed through the missing
+// studies a batch at a time (see StudyPipeline.js) and written out as it goes, from the data file if the
+// price data is not cached yet, or otherwise from the store. progress(dataPointCount, done) is called as
+// batches are completed.
+StudyCache.prototype.prepare = function(studyDefinitions, dataParser, progress, callback) {
+    var self = this;
+    var store = self.store;
+    var parse = !store.isComplete();
+    var missingDefinitions = [];
+    var timeframeDefinitions = [];
+    var studyGraph = null;
+    var studyKeys = {};
+    var pipeline = null;
+    var stopTimer = null;
+    var start = 0;
+
+    // Start the price data over, if it is not cached.
+    if (parse) {
+        store.create(ColumnStore.baseColumns);
+    }
+
+    // Studies on higher timeframes are computed once the prepared data is complete.
+    missingDefinitions = self.getMissingDefinitions(studyDefinitions);
+    timeframeDefinitions = missingDefinitions.filter(function(studyDefinition) {
+        return timeframes.getTimeframe(studyDefinition) > 1;
+    });
+    studyGraph = studyRunner.buildGraph(missingDefinitions.filter(function(studyDefinition) {
+        return timeframes.getTimeframe(studyDefinition) === 1;
+    }));
+
+    if (!parse && !studyGraph.length) {
+        try {
+            self.prepareTimeframes(timeframeDefinitions);
+        }
+        catch (error) {
+            callback(error);
+            return;
+        }
+
+        callback();
+        return;
+    }
+
+    studyKeys = getStudyKeys(studyGraph);
+
+    store.beginColumns(Object.keys(studyKeys));
+
+    pipeline = new StudyPipeline(studyGraph, self.gapThreshold, function(columns, outputs) {
+        var stopWriteTimer = metrics.time('writeColumns');
+
+        if (parse) {
+            store.append(columns);
+        }
+        store.appendColumns(outputs);
+
+        stopWriteTimer();
+
+        progress(pipeline.getCount(), false);
+    });
+
+    // Errors committing the data (or from studies, when computing the last batch) are passed to the
+    // callback, rather than being thrown from inside the parser's promise where nothing would see them.
+    // Anything the callback itself throws is rethrown by done().
+    function finish() {
+        try {
+            pipeline.end();
+
+            store.commitColumns(studyKeys);
+            if (parse) {
+                store.markComplete();
+            }
+
+            self.prepareTimeframes(timeframeDefinitions);
+        }
+        catch (error) {
+            callback(error);
+            return;
+        }
+
+        progress(pipeline.getCount(), true);
+        callback();
+    }
+
+    if (!parse) {
+        // Add the missing studies to the cached price data.
+        try {
+            for (start = 0; start < store.getCount(); start += ColumnStore.chunkSize) {
+                pipeline.push(store.readColumns(ColumnStore.baseColumns, start, ColumnStore.chunkSize));
+            }
+        }
+        catch (error) {
+            callback(error);
+            return;
+        }
+
+        finish();
+        return;
+    }
+
+    // Time spent parsing is the time between batches.
+    stopTimer = metrics.time('parse');
+
+    dataParser.parseColumns(self.dataFilePath, function(columns) {
+        stopTimer();
+        metrics.increment('parsedDataPoints', columns.length);
+
+        pipeline.push(columns);
+
+        stopTimer = metrics.time('parse');
+    }).then(function(columns) {
+        stopTimer();
+
+        // Include any data points not handed over in batches.
+        if (columns && columns.timestamp && columns.timestamp.length) {
+            try {
+                pipeline.push(columns);
+            }
+            catch (error) {
+                callback(error);
+                return;
+            }
+        }
+
+        finish();
+    }, callback).done();
+};
+
+module.exports = StudyCache;
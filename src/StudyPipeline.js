@@ -0,0 +1,121 @@
+var studyRunner = require('./studyRunner');
+var ColumnStore = require('./ColumnStore');
+var metrics = require('./metrics');
+
+// Minimum number of data points to compute studies over at a time.
+var minimumBatchSize = 50000;
+
+// Computes studies over price data as it is parsed (or read), a batch at a time, handing each batch's
+// columns and study outputs to sink(columns, outputs) as soon as they are computed.
+//
+// Studies start over wherever there is a significant gap, keeping only their running values (previous
+// EMAs, average gains, etc.) from one gap-free segment to the next. So batches are made of whole segments,
+// and the same study instances compute every batch, which gives exactly the outputs of computing all of
+// the data at once. Memory use depends on the batch size and the longest segment rather than the length
+// of the data.
+function StudyPipeline(studyGraph, gapThreshold, sink) {
+    var self = this;
+
+    self.studyGraph = studyGraph;
+    self.gapThreshold = gapThreshold;
+    self.sink = sink;
+    self.capacity = minimumBatchSize * 2;
+    self.pending = {};
+    self.pendingCount = 0;
+    self.lastResetIndex = 0;
+    self.previousTimestamp = NaN;
+    self.count = 0;
+
+    ColumnStore.baseColumns.forEach(function(columnName) {
+        self.pending[columnName] = new Float64Array(self.capacity);
+    });
+}
+
+// Returns the number of data points handed to the sink so far.
+StudyPipeline.prototype.getCount = function() {
+    return this.count;
+};
+
+StudyPipeline.prototype.grow = function(capacity) {
+    var self = this;
+
+    while (self.capacity < capacity) {
+        self.capacity *= 2;
+    }
+
+    ColumnStore.baseColumns.forEach(function(columnName) {
+        var values = new Float64Array(self.capacity);
+
+        values.set(self.pending[columnName].subarray(0, self.pendingCount));
+        self.pending[columnName] = values;
+    });
+};
+
+// Adds price data columns (in order, following any added before).
+StudyPipeline.prototype.push = function(columns) {
+    var self = this;
+    var count = columns.timestamp.length;
+    var timestamps = columns.timestamp;
+    var i = 0;
+
+    if (self.pendingCount + count > self.capacity) {
+        self.grow(self.pendingCount + count);
+    }
+
+    ColumnStore.baseColumns.forEach(function(columnName) {
+        self.pending[columnName].set(columns[columnName].subarray(0, count), self.pendingCount);
+    });
+
+    // Find where the last segment starts.
+    for (i = 0; i < count; i++) {
+        if (timestamps[i] - self.previousTimestamp > self.gapThreshold) {
+            self.lastResetIndex = self.pendingCount + i;
+        }
+
+        self.previousTimestamp = timestamps[i];
+    }
+
+    self.pendingCount += count;
+
+    // Compute all complete segments, once there are enough of them. The last segment may continue.
+    if (self.lastResetIndex >= minimumBatchSize) {
+        self.flush(self.lastResetIndex);
+    }
+};
+
+// Computes studies for the first count pending data points, which must end at the end of a segment.
+StudyPipeline.prototype.flush = function(count) {
+    var self = this;
+    var batch = {
+        length: count
+    };
+    var outputs = null;
+    var stopTimer = metrics.time('computeStudies');
+
+    ColumnStore.baseColumns.forEach(function(columnName) {
+        batch[columnName] = self.pending[columnName].subarray(0, count);
+    });
+    batch.resets = studyRunner.buildResets(batch.timestamp, self.gapThreshold);
+
+    outputs = studyRunner.run(self.studyGraph, batch);
+    stopTimer();
+
+    self.sink(batch, outputs);
+    self.count += count;
+
+    // Move the rest of the pending data to the front.
+    ColumnStore.baseColumns.forEach(function(columnName) {
+        self.pending[columnName].set(self.pending[columnName].subarray(count, self.pendingCount));
+    });
+    self.pendingCount -= count;
+    self.lastResetIndex -= count;
+};
+
+// Computes studies for the remaining data.
+StudyPipeline.prototype.end = function() {
+    if (this.pendingCount) {
+        this.flush(this.pendingCount);
+    }
+};
+
+module.exports = StudyPipeline;
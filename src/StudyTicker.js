@@ -0,0 +1,208 @@
+var studyRunner = require('./studyRunner');
+var timeframes = require('./timeframes');
+var buffers = require('./buffers');
+
+// Number of recent data points kept for studies to look back over, and the number at which the oldest
+// are dropped (as studyRunner.tickSeries() does).
+var keptDataPointCount = 1000;
+var maximumDataPointCount = 2000;
+
+// Study properties that are set up from the study definitions rather than being state.
+var configurationProperties = ['inputs', 'outputMap', 'data', 'dataPointCount', 'constructor'];
+
+// Advances studies one data point at a time as live data arrives, by calling each study's tick() on the
+// latest data point, rather than computing series over prepared data. Each tick only looks at as many
+// recent data points as the study needs (its running values carry everything before that), so data
+// points are given exactly the study values that preparing the same data would have given them.
+//
+// Studies start over after gaps as they do when prepared. Only the prepared data's own timeframe is
+// supported, since higher timeframe bars are only complete once a later bar arrives.
+function StudyTicker(studyDefinitions, gapThreshold) {
+    studyDefinitions.forEach(function(studyDefinition) {
+        if (timeframes.getTimeframe(studyDefinition) > 1) {
+            throw 'Studies on higher timeframes cannot be ticked.';
+        }
+    });
+
+    this.studyGraph = studyRunner.buildGraph(studyDefinitions);
+    this.gapThreshold = gapThreshold;
+    this.dataPoints = [];
+    this.previousTimestamp = NaN;
+}
+
+StudyTicker.prototype.getLastTimestamp = function() {
+    return this.previousTimestamp;
+};
+
+// Adds the next data point (with timestamp, volume, open, high, low and close), augmenting it with study
+// values. Missing values are empty strings, as they are in prepared data.
+StudyTicker.prototype.tick = function(dataPoint) {
+    var dataPoints = this.dataPoints;
+    var nodes = this.studyGraph;
+    var study = null;
+    var studyTickValues = null;
+    var outputMaps = null;
+    var outputKey = '';
+    var outputName = '';
+    var value;
+    var i = 0;
+    var j = 0;
+
+    if (dataPoint.timestamp - this.previousTimestamp > this.gapThreshold) {
+        dataPoints = this.dataPoints = [];
+    }
+    this.previousTimestamp = dataPoint.timestamp;
+
+    dataPoints.push(dataPoint);
+
+    for (i = 0; i < nodes.length; i++) {
+        study = nodes[i].study;
+        outputMaps = nodes[i].outputMaps;
+
+        study.setData(dataPoints);
+        studyTickValues = study.tick();
+
+        // Studies with the same inputs share an instance, so fan out its values to each output map.
+        for (j = 0; j < outputMaps.length; j++) {
+            for (outputKey in outputMaps[j]) {
+                outputName = outputMaps[j][outputKey];
+                value = studyTickValues ? studyTickValues[study.getOutputMapping(outputKey)] : undefined;
+
+                dataPoint[outputName] = typeof value === 'number' && value === value ? value : '';
+            }
+        }
+    }
+
+    // Periodically free up memory.
+    if (dataPoints.length >= maximumDataPointCount) {
+        dataPoints.splice(0, dataPoints.length - keptDataPointCount);
+    }
+
+    return dataPoint;
+};
+
+// Returns the state of the studies (their running values, and the recent data points they look back
+// over) as something that can be saved as JSON.
+StudyTicker.prototype.getState = function() {
+    var recentDataPoints = this.dataPoints.slice(-keptDataPointCount);
+
+    return {
+        previousTimestamp: this.previousTimestamp === this.previousTimestamp ? this.previousTimestamp : null,
+        dataPoints: recentDataPoints.map(function(dataPoint) {
+            return {
+                timestamp: dataPoint.timestamp,
+                volume: dataPoint.volume,
+                open: dataPoint.open,
+                high: dataPoint.high,
+                low: dataPoint.low,
+                close: dataPoint.close
+            };
+        }),
+        studies: this.studyGraph.reduce(function(studies, node) {
+            studies[node.key] = encodeProperties(node.study, recentDataPoints, configurationProperties);
+
+            return studies;
+        }, {})
+    };
+};
+
+// Restores state returned by getState() for the same study definitions.
+StudyTicker.prototype.setState = function(state) {
+    var self = this;
+
+    self.studyGraph.forEach(function(node) {
+        if (!state.studies[node.key]) {
+            throw 'No saved state for study ' + node.key;
+        }
+    });
+
+    self.previousTimestamp = state.previousTimestamp === null ? NaN : state.previousTimestamp;
+    self.dataPoints = state.dataPoints;
+
+    self.studyGraph.forEach(function(node) {
+        decodeProperties(node.study, state.studies[node.key], self.dataPoints);
+    });
+};
+
+// Encodes a value for JSON: NaNs and infinities (which JSON cannot hold), typed arrays, references to
+// recent data points (which studies compare by identity), and nested objects such as rolling windows.
+function encodeValue(value, dataPoints) {
+    var index = -1;
+
+    if (typeof value === 'number') {
+        return isFinite(value) ? value : {number: String(value)};
+    }
+
+    if (!value || typeof value !== 'object') {
+        return value;
+    }
+
+    // Typed arrays are saved as their bytes, which keeps them exact and is much quicker than numbers.
+    if (ArrayBuffer.isView(value)) {
+        return {bytes: buffers.from(new Uint8Array(value.buffer, value.byteOffset, value.byteLength)).toString('base64')};
+    }
+
+    if (value instanceof Array) {
+        return {array: value.map(function(item) {
+            return encodeValue(item, dataPoints);
+        })};
+    }
+
+    index = dataPoints.lastIndexOf(value);
+    if (index > -1) {
+        return {dataPoint: index};
+    }
+
+    return {properties: encodeProperties(value, dataPoints, [])};
+}
+
+function encodeProperties(object, dataPoints, excludedProperties) {
+    var encoded = {};
+
+    Object.keys(object).forEach(function(property) {
+        if (excludedProperties.indexOf(property) === -1 && typeof object[property] !== 'function') {
+            encoded[property] = encodeValue(object[property], dataPoints);
+        }
+    });
+
+    return encoded;
+}
+
+// Decodes a value returned by encodeValue(), reusing the existing value where it is a typed array or
+// nested object so that instances keep their prototypes.
+function decodeValue(encoded, existing, dataPoints) {
+    if (!encoded || typeof encoded !== 'object') {
+        return encoded;
+    }
+
+    if (encoded.number !== undefined) {
+        return Number(encoded.number);
+    }
+
+    if (encoded.bytes !== undefined) {
+        new Uint8Array(existing.buffer, existing.byteOffset, existing.byteLength).set(buffers.from(encoded.bytes, 'base64'));
+        return existing;
+    }
+
+    if (encoded.array) {
+        return encoded.array.map(function(item) {
+            return decodeValue(item, undefined, dataPoints);
+        });
+    }
+
+    if (encoded.dataPoint !== undefined) {
+        return dataPoints[encoded.dataPoint];
+    }
+
+    return decodeProperties(existing && typeof existing === 'object' ? existing : {}, encoded.properties, dataPoints);
+}
+
+function decodeProperties(object, encoded, dataPoints) {
+    Object.keys(encoded).forEach(function(property) {
+        object[property] = decodeValue(encoded[property], object[property], dataPoints);
+    });
+
+    return object;
+}
+
+module.exports = StudyTicker;
@@ -0,0 +1,206 @@
+var metrics = require('./metrics');
+
+var defaultOptions = {
+    // Number of documents to insert at a time.
+    batchSize: 5000,
+
+    // Maximum number of milliseconds documents wait in the buffer before being inserted.
+    flushInterval: 1000,
+
+    // Maximum number of inserts in progress at once. Documents pushed beyond this wait in the buffer.
+    maximumInFlight: 2,
+
+    // Write concern for inserts (see the MongoDB documentation for w). 0 does not wait for the database
+    // to acknowledge writes.
+    writeConcern: 1
+};
+
+// Error code for inserting a document with an ID already in the collection.
+var duplicateKeyErrorCode = 11000;
+
+// Returns whether every document an insert failed for was rejected as already being in the collection.
+function isDuplicateKeyError(error) {
+    return (error.writeErrors || [error]).every(function(writeError) {
+        return writeError.code === duplicateKeyErrorCode;
+    });
+}
+
+// Collects documents to insert into a collection, coalescing them into large unordered bulk inserts with
+// a bounded number in progress at once. Many small inserts (for example the positions closed in each
+// block of a backtest) spend most of their time in round trips, and unordered inserts let the database
+// apply each batch in parallel rather than one document after another.
+//
+// Documents are inserted once a batch's worth has been pushed, once the oldest has waited the flush
+// interval, or when flushed. Since the inserts are unordered and more than one may be in progress,
+// whenWritten() is the way to find out that everything pushed so far is in the database.
+function WriteBuffer(collection, options) {
+    var optionName = '';
+
+    options = options || {};
+
+    for (optionName in defaultOptions) {
+        if (options[optionName] === undefined) {
+            options[optionName] = defaultOptions[optionName];
+        }
+    }
+
+    this.collection = collection;
+    this.options = options;
+    this.documents = [];
+    this.timer = null;
+    this.flushing = false;
+
+    // Documents are numbered in the order they are pushed in order to tell what has been written.
+    this.pushedCount = 0;
+    this.inFlight = [];
+    this.waiters = [];
+    this.acceptors = [];
+}
+
+// Name used for metrics about this buffer's inserts.
+WriteBuffer.prototype.getMetricName = function() {
+    return this.options.metricName || ('mongo.insert.' + this.collection.name);
+};
+
+// Returns the number of the first document not known to be written.
+WriteBuffer.prototype.getWrittenCount = function() {
+    var writtenCount = this.pushedCount - this.documents.length;
+
+    this.inFlight.forEach(function(batch) {
+        writtenCount = Math.min(writtenCount, batch.start);
+    });
+
+    return writtenCount;
+};
+
+WriteBuffer.prototype.isFull = function() {
+    return this.inFlight.length >= this.options.maximumInFlight && this.documents.length >= this.options.batchSize;
+};
+
+// Adds documents to insert. The callback is called once the buffer can take more, which is immediately
+// unless inserts are falling behind.
+WriteBuffer.prototype.push = function(documents, callback) {
+    var self = this;
+
+    callback = callback || function() {};
+
+    if (documents.length) {
+        Array.prototype.push.apply(self.documents, documents);
+        self.pushedCount += documents.length;
+
+        metrics.setGauge(self.getMetricName() + '.buffered', self.documents.length);
+    }
+
+    self.send();
+
+    if (self.isFull()) {
+        self.acceptors.push(callback);
+        return;
+    }
+
+    callback();
+};
+
+// Calls back once every document pushed so far has been written, without forcing an insert.
+WriteBuffer.prototype.whenWritten = function(callback) {
+    if (this.getWrittenCount() >= this.pushedCount) {
+        callback();
+        return;
+    }
+
+    this.waiters.push({
+        count: this.pushedCount,
+        callback: callback
+    });
+};
+
+// Inserts every buffered document now, calling back once everything pushed so far has been written.
+WriteBuffer.prototype.flush = function(callback) {
+    this.flushing = true;
+    this.send();
+    this.whenWritten(callback || function() {});
+};
+
+// Starts inserts of buffered documents, in full batches unless flushing, up to the in-flight limit. Any
+// documents left are inserted once the flush interval has passed. A flush with inserts at the limit
+// continues as inserts finish.
+WriteBuffer.prototype.send = function() {
+    var self = this;
+
+    while (self.inFlight.length < self.options.maximumInFlight && self.documents.length && (self.flushing || self.documents.length >= self.options.batchSize)) {
+        self.insert(self.documents.splice(0, self.options.batchSize));
+    }
+
+    if (!self.documents.length) {
+        self.flushing = false;
+    }
+
+    if (self.timer && (!self.documents.length || self.flushing)) {
+        clearTimeout(self.timer);
+        self.timer = null;
+    }
+
+    if (!self.timer && !self.flushing && self.documents.length) {
+        self.timer = setTimeout(function() {
+            self.timer = null;
+            self.flushing = true;
+            self.send();
+        }, self.options.flushInterval);
+    }
+
+    metrics.setGauge(self.getMetricName() + '.buffered', self.documents.length);
+    metrics.setGauge(self.getMetricName() + '.inFlight', self.inFlight.length);
+};
+
+WriteBuffer.prototype.insert = function(documents) {
+    var self = this;
+    var batch = {
+        start: self.pushedCount - self.documents.length - documents.length
+    };
+    var options = {
+        ordered: false,
+        w: self.options.writeConcern
+    };
+
+    self.inFlight.push(batch);
+
+    self.collection.insertMany(documents, options, metrics.timeCallback(self.getMetricName(), function(error) {
+        // The documents that could be inserted were, since the insert is unordered. Documents already in
+        // the database are expected when their IDs are deterministic (a resumed run saves some positions
+        // again), so only other errors are reported.
+        if (error && !isDuplicateKeyError(error)) {
+            console.error(error.message || error);
+        }
+
+        self.inFlight.splice(self.inFlight.indexOf(batch), 1);
+        metrics.increment(self.getMetricName() + '.documents', documents.length);
+
+        self.send();
+        self.notify();
+    }));
+};
+
+// Calls back anything waiting for documents to be written or for room in the buffer.
+WriteBuffer.prototype.notify = function() {
+    var writtenCount = this.getWrittenCount();
+    var waiter = null;
+    var acceptors = null;
+
+    // Waiters are in the order they were added, which is also the order of the counts they wait for.
+    while (this.waiters.length && this.waiters[0].count <= writtenCount) {
+        waiter = this.waiters.shift();
+        waiter.callback();
+        writtenCount = this.getWrittenCount();
+    }
+
+    if (!this.isFull() && this.acceptors.length) {
+        acceptors = this.acceptors;
+        this.acceptors = [];
+
+        acceptors.forEach(function(callback) {
+            callback();
+        });
+    }
+};
+
+module.exports = WriteBuffer;
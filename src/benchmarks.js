@@ -0,0 +1,764 @@
+// Benchmarks for the parts of a run where time goes: parsing data files, computing studies, backtesting
+// strategies, and optimizing end to end. Fixtures are either minute bars generated from a seed (so runs are
+// reproducible across machines and releases) or a recorded data file.
+
+var fs = require('fs');
+var path = require('path');
+var os = require('os');
+var _ = require('lodash');
+var async = require('async');
+var studies = require('./studies');
+var kernels = require('./studies/kernels');
+var studyRunner = require('./studyRunner');
+var scanner = require('./dataParsers/scanner');
+var dataParsers = require('./dataParsers');
+var strategyFns = require('./strategies');
+var SignalMatrix = require('./SignalMatrix');
+var ColumnStore = require('./ColumnStore');
+var ConfigurationSpace = require('./ConfigurationSpace');
+
+// Gap (in milliseconds) after which studies start over, as used by optimizers.
+var gapThreshold = 65 * 1000;
+
+// Inputs used to benchmark each study class, with outputs mapped to their own names.
+var studyInputs = {
+    Ema: {inputs: {length: 200}, outputs: ['ema']},
+    Sma: {inputs: {length: 200}, outputs: ['sma']},
+    Rsi: {inputs: {length: 14}, outputs: ['rsi']},
+    DynamicZoneRsi: {inputs: {length: 14, bandsLength: 50, deviations: 2}, outputs: ['rsi', 'upper', 'lower']},
+    AverageTrueRange: {inputs: {length: 14}, outputs: ['atr']},
+    PolynomialRegressionChannel: {inputs: {length: 200, degree: 2, deviations: 2}, outputs: ['regression', 'upper', 'lower']},
+    AverageVolume: {inputs: {length: 20}, outputs: ['average']},
+    StochasticOscillator: {inputs: {length: 14, averageLength: 3}, outputs: ['K', 'D']},
+    BollingerBands: {inputs: {length: 20, deviations: 2}, outputs: ['middle', 'upper', 'lower']},
+    AverageDirectionalIndex: {inputs: {length: 14}, outputs: ['pDI', 'mDI', 'ADX']}
+};
+
+// Returns a pseudo-random number generator (mulberry32) producing numbers in [0, 1) for a seed.
+function createRandom(seed) {
+    var state = seed >>> 0;
+
+    return function() {
+        var value = 0;
+
+        state = (state + 0x6d2b79f5) >>> 0;
+        value = Math.imul(state ^ (state >>> 15), 1 | state);
+        value = (value + Math.imul(value ^ (value >>> 7), 61 | value)) ^ value;
+
+        return ((value ^ (value >>> 14)) >>> 0) / 4294967296;
+    };
+}
+
+// Returns seconds elapsed since a process.hrtime() start time.
+function getSeconds(startTime) {
+    var elapsed = process.hrtime(startTime);
+
+    return elapsed[0] + elapsed[1] / 1e9;
+}
+
+function getRate(count, seconds) {
+    return seconds > 0 ? Math.round(count / seconds) : 0;
+}
+
+// Returns the first count rows of columns (sharing their buffers).
+function sliceColumns(columns, count) {
+    var sliced = {
+        length: Math.min(count, columns.length)
+    };
+
+    ['timestamp', 'volume', 'open', 'high', 'low', 'close'].forEach(function(columnName) {
+        sliced[columnName] = columns[columnName].subarray(0, sliced.length);
+    });
+    sliced.resets = studyRunner.buildResets(sliced.timestamp, gapThreshold);
+
+    return sliced;
+}
+
+function padNumber(number, length) {
+    var text = String(number);
+
+    while (text.length < length) {
+        text = '0' + text;
+    }
+
+    return text;
+}
+
+// Generates minute bars as a random walk with weekend gaps, starting Monday, January 5, 2015 (local time).
+// Prices have three decimal places and volumes are whole numbers, so they survive a round trip through a
+// data file exactly.
+module.exports.generateColumns = function(count, seed) {
+    var random = createRandom(seed);
+    var columns = new scanner.ColumnBuilder();
+    var date = new Date(2015, 0, 5, 0, 0, 0, 0);
+    var close = 100;
+    var open = 0.0;
+    var high = 0.0;
+    var low = 0.0;
+    var i = 0;
+
+    for (i = 0; i < count; i++) {
+        // Skip weekends.
+        while (date.getDay() === 0 || date.getDay() === 6) {
+            date.setDate(date.getDate() + 1);
+        }
+
+        open = close;
+        close = Math.max(Math.round((open + (random() - 0.5) * 0.05) * 1000) / 1000, 1);
+        high = Math.round((Math.max(open, close) + random() * 0.02) * 1000) / 1000;
+        low = Math.round((Math.min(open, close) - random() * 0.02) * 1000) / 1000;
+
+        columns.push(date.getTime(), 1 + Math.floor(random() * 200), open, high, low, close);
+
+        date.setMinutes(date.getMinutes() + 1);
+    }
+
+    return columns.getColumns();
+};
+
+// Writes columns to a data file in a parser's format.
+module.exports.writeDataFile = function(parserName, columns, filePath) {
+    var fileDescriptor = fs.openSync(filePath, 'w');
+    var lines = [];
+    var date = null;
+    var i = 0;
+
+    function formatPrices(index) {
+        return [columns.open[index], columns.high[index], columns.low[index], columns.close[index]].join(',');
+    }
+
+    if (parserName === 'dukascopy') {
+        lines.push('Time,Open,High,Low,Close,Volume');
+    }
+
+    for (i = 0; i < columns.length; i++) {
+        date = new Date(columns.timestamp[i]);
+
+        if (parserName === 'metatrader') {
+            lines.push(date.getFullYear() + '.' + padNumber(date.getMonth() + 1, 2) + '.' + padNumber(date.getDate(), 2) + ',' +
+                padNumber(date.getHours(), 2) + ':' + padNumber(date.getMinutes(), 2) + ',' + formatPrices(i) + ',' + columns.volume[i]);
+        }
+        else if (parserName === 'dukascopy') {
+            lines.push(padNumber(date.getDate(), 2) + '.' + padNumber(date.getMonth() + 1, 2) + '.' + date.getFullYear() + ' ' +
+                padNumber(date.getHours(), 2) + ':' + padNumber(date.getMinutes(), 2) + ':' + padNumber(date.getSeconds(), 2) + '.000,' + formatPrices(i) + ',' + columns.volume[i]);
+        }
+        else if (parserName === 'ctoption') {
+            lines.push(columns.timestamp[i] + ',' + formatPrices(i));
+        }
+        else {
+            throw 'Unknown data parser ' + parserName + '.';
+        }
+
+        // Write in batches to keep memory use down.
+        if (lines.length >= 10000) {
+            fs.writeSync(fileDescriptor, lines.join('\n') + '\n');
+            lines = [];
+        }
+    }
+
+    if (lines.length) {
+        fs.writeSync(fileDescriptor, lines.join('\n') + '\n');
+    }
+
+    fs.closeSync(fileDescriptor);
+};
+
+// Measures how fast a parser reads a data file. Calls back with the results.
+module.exports.benchmarkParser = function(parserName, filePath, callback) {
+    var megabytes = fs.statSync(filePath).size / (1024 * 1024);
+    var startTime = process.hrtime();
+
+    dataParsers[parserName].parseColumns(filePath).then(function(columns) {
+        var seconds = getSeconds(startTime);
+
+        callback(null, {
+            parser: parserName,
+            file: filePath,
+            megabytes: megabytes,
+            bars: columns.length,
+            seconds: seconds,
+            megabytesPerSecond: seconds > 0 ? megabytes / seconds : 0,
+            barsPerSecond: getRate(columns.length, seconds)
+        });
+    }, callback);
+};
+
+// Measures each study class ticking one data point at a time (at most tickCount data points, since ticking
+// is much slower) and computing its series over all columns.
+module.exports.benchmarkStudies = function(columns, tickCount) {
+    var tickColumns = sliceColumns(columns, tickCount);
+
+    return Object.keys(studies).map(function(studyName) {
+        var definition = studyInputs[studyName] || {inputs: {length: 14}, outputs: []};
+        var outputMap = {};
+        var study = null;
+        var startTime = null;
+        var seconds = 0;
+        var series = null;
+        var result = {
+            study: studyName,
+            inputs: definition.inputs,
+            tick: null,
+            series: null
+        };
+
+        definition.outputs.forEach(function(outputName) {
+            outputMap[outputName] = outputName;
+        });
+
+        study = new studies[studyName](definition.inputs, outputMap);
+        startTime = process.hrtime();
+        studyRunner.tickSeries(study, tickColumns);
+        seconds = getSeconds(startTime);
+
+        result.tick = {
+            bars: tickColumns.length,
+            seconds: seconds,
+            barsPerSecond: getRate(tickColumns.length, seconds)
+        };
+
+        // Intermediates are cached with the columns, so start each study without them.
+        delete columns.intermediates;
+
+        study = new studies[studyName](definition.inputs, outputMap);
+        startTime = process.hrtime();
+        series = study.computeSeries(columns);
+        seconds = getSeconds(startTime);
+
+        delete columns.intermediates;
+
+        if (series) {
+            result.series = {
+                bars: columns.length,
+                seconds: seconds,
+                barsPerSecond: getRate(columns.length, seconds)
+            };
+        }
+
+        return result;
+    });
+};
+
+// Counts the values in a series output that differ from the reference (NaN included), and the largest
+// difference between values present in both.
+function compareSeries(reference, values) {
+    var comparison = {
+        mismatches: 0,
+        maximumDifference: 0
+    };
+    var i = 0;
+
+    for (i = 0; i < reference.length; i++) {
+        if (reference[i] === values[i] || (reference[i] !== reference[i] && values[i] !== values[i])) {
+            continue;
+        }
+
+        comparison.mismatches++;
+
+        if (reference[i] === reference[i] && values[i] === values[i]) {
+            comparison.maximumDifference = Math.max(comparison.maximumDifference, Math.abs(reference[i] - values[i]));
+        }
+    }
+
+    return comparison;
+}
+
+// Adds the mismatches between a study's series outputs and the reference outputs to a result.
+function addComparison(result, outputNames, reference, series) {
+    outputNames.forEach(function(outputName) {
+        var comparison = compareSeries(reference[outputName], series[outputName]);
+
+        result.mismatches += comparison.mismatches;
+        result.maximumDifference = Math.max(result.maximumDifference, comparison.maximumDifference);
+    });
+}
+
+// Checks that computing each study's series gives exactly what ticking it one data point at a time does,
+// with each available kernel backend, and that the native kernels give exactly what the JavaScript ones
+// do. Columns should have gaps, so that studies starting over is checked too. Returns a result for each
+// comparison, with the number of mismatched values.
+module.exports.checkStudies = function(columns) {
+    var results = [];
+
+    Object.keys(studyInputs).forEach(function(studyName) {
+        var definition = studyInputs[studyName];
+        var outputMap = {};
+        var reference = null;
+        var backendSeries = {};
+        var nativeResult = null;
+
+        definition.outputs.forEach(function(outputName) {
+            outputMap[outputName] = outputName;
+        });
+
+        reference = studyRunner.tickSeries(new studies[studyName](definition.inputs, outputMap), columns);
+
+        // Studies without kernels compute their series the same way whichever backend is used.
+        (kernels.js[studyName] ? kernels.getBackendNames() : ['js']).forEach(function(backendName) {
+            var study = new studies[studyName](definition.inputs, outputMap);
+            var result = {
+                study: studyName,
+                backend: backendName,
+                reference: 'tick',
+                mismatches: 0,
+                maximumDifference: 0
+            };
+
+            if (kernels.js[studyName]) {
+                study.seriesKernel = kernels.get(studyName, backendName);
+            }
+
+            // Intermediates are cached with the columns, so start each study without them.
+            delete columns.intermediates;
+            backendSeries[backendName] = study.computeSeries(columns);
+            delete columns.intermediates;
+
+            addComparison(result, definition.outputs, reference, backendSeries[backendName]);
+            results.push(result);
+        });
+
+        if (backendSeries.native) {
+            nativeResult = {
+                study: studyName,
+                backend: 'native',
+                reference: 'js',
+                mismatches: 0,
+                maximumDifference: 0
+            };
+
+            addComparison(nativeResult, definition.outputs, backendSeries.js, backendSeries.native);
+            results.push(nativeResult);
+        }
+    });
+
+    return results;
+};
+
+// Checks each study kernel from each available backend against ticking the study one data point at a time
+// (over at most tickCount data points), and measures each backend computing the series over all columns.
+// Kernels should match tick() exactly, so any mismatch is a bug in the kernel.
+module.exports.benchmarkKernels = function(columns, tickCount) {
+    var tickColumns = sliceColumns(columns, tickCount);
+    var results = [];
+
+    Object.keys(kernels.js).forEach(function(studyName) {
+        var definition = studyInputs[studyName];
+        var outputMap = {};
+        var reference = null;
+
+        definition.outputs.forEach(function(outputName) {
+            outputMap[outputName] = outputName;
+        });
+
+        reference = studyRunner.tickSeries(new studies[studyName](definition.inputs, outputMap), tickColumns);
+
+        kernels.getBackendNames().forEach(function(backendName) {
+            var study = new studies[studyName](definition.inputs, outputMap);
+            var series = null;
+            var startTime = null;
+            var seconds = 0;
+            var result = {
+                study: studyName,
+                backend: backendName,
+                mismatches: 0,
+                maximumDifference: 0
+            };
+
+            study.seriesKernel = kernels.get(studyName, backendName);
+            series = study.computeSeries(tickColumns);
+            delete tickColumns.intermediates;
+
+            addComparison(result, definition.outputs, reference, series);
+
+            study = new studies[studyName](definition.inputs, outputMap);
+            study.seriesKernel = kernels.get(studyName, backendName);
+
+            // Intermediates are cached with the columns, so time each kernel without them.
+            delete columns.intermediates;
+            startTime = process.hrtime();
+            study.computeSeries(columns);
+            seconds = getSeconds(startTime);
+            delete columns.intermediates;
+
+            result.bars = columns.length;
+            result.seconds = seconds;
+            result.barsPerSecond = getRate(columns.length, seconds);
+
+            results.push(result);
+        });
+    });
+
+    return results;
+};
+
+// Returns count configuration indexes spread evenly across a configuration space.
+function sampleConfigurationIndexes(configurationSpace, count) {
+    var spaceCount = configurationSpace.getCount();
+    var indexes = [];
+    var i = 0;
+
+    count = Math.min(count, spaceCount);
+
+    for (i = 0; i < count; i++) {
+        indexes.push(Math.floor(i * spaceCount / count));
+    }
+
+    return indexes;
+}
+
+// Builds data points for a block of columns, using empty strings for missing values as prepared data
+// points do.
+function buildDataPoints(columns, columnNames, start, count) {
+    var dataPoints = [];
+    var dataPoint;
+    var value = 0.0;
+    var i = 0;
+    var j = 0;
+
+    for (i = start; i < start + count; i++) {
+        dataPoint = {};
+
+        for (j = 0; j < columnNames.length; j++) {
+            value = columns[columnNames[j]][i];
+            dataPoint[columnNames[j]] = value === value ? value : '';
+        }
+
+        dataPoints.push(dataPoint);
+    }
+
+    return dataPoints;
+}
+
+// Measures backtesting sampled configurations of an optimizer's strategy, both one data point at a time
+// and (for strategies that support it) a block at a time using a signal matrix. Data is backtested in
+// blocks the size of prepared data store chunks, as workers do, and only time spent backtesting counts.
+module.exports.benchmarkStrategy = function(optimizerFn, columns, configurationCount, investment, profitability) {
+    var optimizer = new optimizerFn('BENCH');
+    var strategyFn = strategyFns.optimization[optimizer.strategyName];
+    var indexes = sampleConfigurationIndexes(optimizer.configurationSpace, configurationCount);
+    var blockCount = Math.ceil(columns.length / ColumnStore.chunkSize);
+    var outputs = null;
+    var allColumns = null;
+    var columnNames = [];
+    var strategies = [];
+    var seconds = [];
+    var blockSeconds = [];
+    var prepareSeconds = 0;
+    var startTime = process.hrtime();
+    var blockIndex = 0;
+
+    // Prepare the study data the strategy needs once for all configurations.
+    delete columns.intermediates;
+    outputs = studyRunner.run(studyRunner.buildGraph(optimizer.studyDefinitions), columns);
+    allColumns = _.extend({}, _.omit(columns, 'length', 'resets'), outputs);
+    columnNames = Object.keys(allColumns);
+    prepareSeconds = getSeconds(startTime);
+
+    function createStrategies() {
+        return indexes.map(function(index) {
+            var strategy = new strategyFn('BENCH', optimizer.configurationSpace.get(index), columns.length);
+
+            strategy.setSavePositions(false);
+
+            return strategy;
+        });
+    }
+
+    // Backtest one data point at a time.
+    strategies = createStrategies();
+
+    for (blockIndex = 0; blockIndex < blockCount; blockIndex++) {
+        (function(start, dataPoints) {
+            strategies.forEach(function(strategy, strategyIndex) {
+                var i = 0;
+
+                startTime = process.hrtime();
+                for (i = 0; i < dataPoints.length; i++) {
+                    strategy.backtest(dataPoints[i], start + i, investment, profitability, function() {});
+                }
+                seconds[strategyIndex] = (seconds[strategyIndex] || 0) + getSeconds(startTime);
+            });
+        })(blockIndex * ColumnStore.chunkSize, buildDataPoints(allColumns, columnNames, blockIndex * ColumnStore.chunkSize, Math.min(ColumnStore.chunkSize, columns.length - blockIndex * ColumnStore.chunkSize)));
+    }
+
+    strategyFn.resetLedger();
+
+    // Backtest a block at a time. Each strategy gets its own matrix for each block, so the time includes
+    // evaluating its conditions.
+    if (strategyFn.prototype.backtestBlock) {
+        strategies = createStrategies();
+
+        for (blockIndex = 0; blockIndex < blockCount; blockIndex++) {
+            strategies.forEach(function(strategy, strategyIndex) {
+                var start = blockIndex * ColumnStore.chunkSize;
+                var end = Math.min(start + ColumnStore.chunkSize, columns.length);
+                var blockColumns = {};
+
+                strategy.getColumnNames().forEach(function(columnName) {
+                    blockColumns[columnName] = allColumns[columnName].subarray(start, end);
+                });
+
+                startTime = process.hrtime();
+                strategy.backtestBlock(new SignalMatrix(blockColumns, end - start), investment, profitability);
+                blockSeconds[strategyIndex] = (blockSeconds[strategyIndex] || 0) + getSeconds(startTime);
+            });
+        }
+
+        strategyFn.resetLedger();
+    }
+
+    return {
+        strategy: optimizer.strategyName,
+        bars: columns.length,
+        configurationCount: optimizer.configurationSpace.getCount(),
+        prepareSeconds: prepareSeconds,
+        configurations: indexes.map(function(index, strategyIndex) {
+            return {
+                index: index,
+                configuration: optimizer.configurationSpace.get(index),
+                backtest: {
+                    seconds: seconds[strategyIndex],
+                    barsPerSecond: getRate(columns.length, seconds[strategyIndex])
+                },
+                backtestBlock: blockSeconds.length ? {
+                    seconds: blockSeconds[strategyIndex],
+                    barsPerSecond: getRate(columns.length, blockSeconds[strategyIndex])
+                } : null
+            };
+        })
+    };
+};
+
+// Returns configuration options narrowed (keeping the first values of each option) to a space of at most
+// count configurations, widening the last options first.
+module.exports.narrowConfigurationOptions = function(options, count) {
+    var keys = Object.keys(options);
+    var narrowed = {};
+    var total = 1;
+    var i = 0;
+
+    keys.forEach(function(key) {
+        narrowed[key] = options[key].slice(0, 1);
+    });
+
+    for (i = keys.length - 1; i >= 0; i--) {
+        narrowed[keys[i]] = options[keys[i]].slice(0, Math.max(Math.floor(count / total), 1));
+        total *= narrowed[keys[i]].length;
+    }
+
+    return narrowed;
+};
+
+// Removes prepared data from a store so that it is prepared again.
+function clearStore(store) {
+    var manifest = store.load();
+
+    if (!manifest) {
+        return;
+    }
+
+    store.close();
+
+    manifest.columns.forEach(function(columnName) {
+        if (fs.existsSync(store.getColumnPath(columnName))) {
+            fs.unlinkSync(store.getColumnPath(columnName));
+        }
+    });
+    fs.unlinkSync(store.getManifestPath());
+}
+
+// Measures optimize() end to end (preparing study data and backtesting with worker forks in aggregate-only
+// mode) over a narrowed configuration space. Backtests are saved under the BENCH symbol, which is cleared
+// before and after the run. Requires a database connection.
+module.exports.benchmarkOptimize = function(optimizerFn, parserName, dataFilePath, configurationCount, investment, profitability, callback) {
+    var Backtest = require('./models/Backtest');
+    var optimizer = new optimizerFn('BENCH');
+    var startTime = null;
+    var result = {
+        optimizer: optimizer.strategyName,
+        bars: 0,
+        configurationCount: 0,
+        seconds: 0,
+        barsPerSecond: 0
+    };
+    var tasks = [];
+
+    optimizer.configurationSpace = new ConfigurationSpace(module.exports.narrowConfigurationOptions(optimizer.configurationSpace.getOptions(), configurationCount));
+    optimizer.setAggregateOnly(null);
+    result.configurationCount = optimizer.configurationSpace.getCount();
+
+    // Start from nothing, so that every configuration is backtested and the data is prepared again.
+    tasks.push(function(taskCallback) {
+        clearStore(optimizer.getStudyCache(dataFilePath).getStore());
+        Backtest.remove({symbol: 'BENCH'}, taskCallback);
+    });
+
+    tasks.push(function(taskCallback) {
+        startTime = process.hrtime();
+
+        optimizer.optimize(dataParsers[parserName], dataFilePath, investment, profitability, function() {
+            result.seconds = getSeconds(startTime);
+            result.bars = optimizer.store.getCount();
+            result.barsPerSecond = getRate(result.bars * result.configurationCount, result.seconds);
+
+            taskCallback();
+        });
+    });
+
+    tasks.push(function(taskCallback) {
+        clearStore(optimizer.store);
+        Backtest.remove({symbol: 'BENCH'}, taskCallback);
+    });
+
+    async.series(tasks, function(error) {
+        callback(error, result);
+    });
+};
+
+// Runs every benchmark, calling back with the results. Options:
+//
+//     bars                    Number of synthetic bars to generate.
+//     seed                    Seed for generating synthetic bars.
+//     tickBars                Maximum number of bars to tick studies over.
+//     configurations          Number of configurations to sample for each strategy.
+//     parser, data            A recorded data file to use instead of synthetic bars (optional).
+//     optimizer               Optimizer to run end to end (only if database is set).
+//     optimizeConfigurations  Number of configurations to optimize end to end.
+//     investment, profitability
+//     directory               Directory for fixture files.
+module.exports.run = function(options, callback) {
+    var columns = null;
+    var fixtureFiles = {};
+    var results = {
+        timestamp: new Date().toISOString(),
+        node: process.version,
+        platform: os.platform() + ' ' + os.arch(),
+        cpu: os.cpus()[0] ? os.cpus()[0].model : '',
+        cpuCount: os.cpus().length,
+        fixture: null,
+        parsers: [],
+        studies: [],
+        kernels: [],
+        strategies: [],
+        optimize: null
+    };
+    var tasks = [];
+
+    function log(message) {
+        process.stdout.write(message + '\n');
+    }
+
+    // Load the fixture.
+    tasks.push(function(taskCallback) {
+        if (options.data) {
+            log('Loading ' + options.data + '...');
+
+            dataParsers[options.parser].parseColumns(options.data).then(function(parsedColumns) {
+                columns = parsedColumns;
+                results.fixture = {type: 'recorded', file: options.data, parser: options.parser, bars: columns.length};
+                taskCallback();
+            }, taskCallback);
+            return;
+        }
+
+        log('Generating ' + options.bars + ' bars...');
+
+        columns = module.exports.generateColumns(options.bars, options.seed);
+        results.fixture = {type: 'synthetic', seed: options.seed, bars: columns.length};
+        taskCallback();
+    });
+
+    // Write the fixture in each parser's format, and parse each file.
+    tasks.push(function(taskCallback) {
+        var parserTasks = [];
+
+        Object.keys(dataParsers).forEach(function(parserName) {
+            fixtureFiles[parserName] = path.join(options.directory, 'fixture-' + parserName + '.csv');
+
+            parserTasks.push(function(parserCallback) {
+                log('Parsing with ' + parserName + '...');
+
+                module.exports.writeDataFile(parserName, columns, fixtureFiles[parserName]);
+                module.exports.benchmarkParser(parserName, fixtureFiles[parserName], function(error, result) {
+                    if (result) {
+                        results.parsers.push(result);
+                    }
+                    parserCallback(error);
+                });
+            });
+        });
+
+        if (options.data) {
+            parserTasks.push(function(parserCallback) {
+                module.exports.benchmarkParser(options.parser, options.data, function(error, result) {
+                    if (result) {
+                        result.recorded = true;
+                        results.parsers.push(result);
+                    }
+                    parserCallback(error);
+                });
+            });
+        }
+
+        async.series(parserTasks, taskCallback);
+    });
+
+    tasks.push(function(taskCallback) {
+        columns.resets = studyRunner.buildResets(columns.timestamp, gapThreshold);
+
+        log('Running studies...');
+        results.studies = module.exports.benchmarkStudies(columns, options.tickBars);
+
+        log('Checking study kernels...');
+        results.kernels = module.exports.benchmarkKernels(columns, options.tickBars);
+        results.kernels.forEach(function(result) {
+            if (result.mismatches) {
+                log(result.study + ' kernel (' + result.backend + ') differs from tick() at ' + result.mismatches + ' values, by up to ' + result.maximumDifference);
+            }
+        });
+
+        taskCallback();
+    });
+
+    tasks.push(function(taskCallback) {
+        var optimizers = require('./optimizers');
+
+        Object.keys(strategyFns.optimization).forEach(function(strategyName) {
+            if (!optimizers[strategyName]) {
+                return;
+            }
+
+            log('Backtesting ' + strategyName + '...');
+            results.strategies.push(module.exports.benchmarkStrategy(optimizers[strategyName], columns, options.configurations, options.investment, options.profitability));
+        });
+
+        taskCallback();
+    });
+
+    tasks.push(function(taskCallback) {
+        var optimizers = require('./optimizers');
+
+        if (!options.database) {
+            taskCallback();
+            return;
+        }
+
+        // Optimize using the fixture file written for the metatrader parser, unless a recorded file is used.
+        module.exports.benchmarkOptimize(
+            optimizers[options.optimizer],
+            options.data ? options.parser : 'metatrader',
+            options.data || fixtureFiles.metatrader,
+            options.optimizeConfigurations,
+            options.investment,
+            options.profitability,
+            function(error, result) {
+                results.optimize = result;
+                taskCallback(error);
+            }
+        );
+    });
+
+    async.series(tasks, function(error) {
+        callback(error, results);
+    });
+};
@@ -0,0 +1,19 @@
+// Creates buffers without the Buffer constructor, which is deprecated in newer versions of Node.js, while
+// still working on older versions that only have the constructor. Early versions of Node.js 4 have a
+// Buffer.from that is really Uint8Array.from, so that does not count.
+var hasFrom = typeof Buffer.from === 'function' && Buffer.from !== Uint8Array.from;
+var hasAlloc = typeof Buffer.allocUnsafe === 'function';
+
+// Whether buffers can be created over the memory of an ArrayBuffer with Buffer.from(arrayBuffer,
+// byteOffset, length), without copying.
+module.exports.canShareMemory = hasFrom;
+
+// Returns a buffer of the given size. Its contents are not initialized, as with the Buffer constructor.
+module.exports.alloc = function(size) {
+    return hasAlloc ? Buffer.allocUnsafe(size) : new Buffer(size);
+};
+
+// Returns a buffer holding a copy of a string (in the given encoding), array or typed array.
+module.exports.from = function(value, encoding) {
+    return hasFrom ? Buffer.from(value, encoding) : new Buffer(value, encoding);
+};
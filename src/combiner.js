@@ -0,0 +1,272 @@
+// Greedily combines the positions of forward tests into one set of positions. Candidates are tried in
+// order, and a candidate's positions are kept if adding them (skipping any at timestamps already taken)
+// improves the combined results enough. Positions are held in timestamp-ordered typed arrays, and each
+// candidate is checked first against running totals for the combined positions; only candidates that
+// pass are merged in full to check consecutive losses and get the exact profit/loss.
+
+// Allowance for rounding when checking the profit/loss from running totals. The exact check follows.
+var profitLossTolerance = 1e-6;
+
+function PositionArrays(capacity) {
+    this.count = 0;
+    this.timestamps = new Float64Array(capacity);
+    this.investments = new Float64Array(capacity);
+    this.profitLosses = new Float64Array(capacity);
+    this.positionIndexes = new Int32Array(capacity);
+}
+
+PositionArrays.prototype.push = function(timestamp, investment, profitLoss, positionIndex) {
+    var index = this.count++;
+
+    this.timestamps[index] = timestamp;
+    this.investments[index] = investment;
+    this.profitLosses[index] = profitLoss;
+    this.positionIndexes[index] = positionIndex;
+};
+
+// Returns whether the timestamp is in the arrays, using binary search.
+PositionArrays.prototype.hasTimestamp = function(timestamp) {
+    var low = 0;
+    var high = this.count - 1;
+    var middle = 0;
+
+    while (low <= high) {
+        middle = (low + high) >>> 1;
+
+        if (this.timestamps[middle] < timestamp) {
+            low = middle + 1;
+        }
+        else if (this.timestamps[middle] > timestamp) {
+            high = middle - 1;
+        }
+        else {
+            return true;
+        }
+    }
+
+    return false;
+};
+
+// Builds timestamp-ordered arrays for each strategy UUID's positions. Only the first position at each
+// timestamp is kept.
+function groupPositions(positions) {
+    var indexesByUuid = {};
+    var positionArrays = {};
+    var strategyUuid = '';
+
+    positions.forEach(function(position, index) {
+        if (!indexesByUuid[position.strategyUuid]) {
+            indexesByUuid[position.strategyUuid] = [];
+        }
+        indexesByUuid[position.strategyUuid].push(index);
+    });
+
+    for (strategyUuid in indexesByUuid) {
+        positionArrays[strategyUuid] = (function(indexes) {
+            var arrays = new PositionArrays(indexes.length);
+            var seenTimestamps = {};
+
+            // Drop later positions at the same timestamp, then order by timestamp.
+            indexes.filter(function(index) {
+                var timestamp = positions[index].timestamp;
+
+                if (seenTimestamps[timestamp]) {
+                    return false;
+                }
+
+                seenTimestamps[timestamp] = true;
+
+                return true;
+            }).sort(function(a, b) {
+                return positions[a].timestamp - positions[b].timestamp;
+            }).forEach(function(index) {
+                arrays.push(positions[index].timestamp, positions[index].investment, positions[index].profitLoss, index);
+            });
+
+            return arrays;
+        })(indexesByUuid[strategyUuid]);
+    }
+
+    return positionArrays;
+}
+
+// Merges candidate positions with timestamps not already taken into the combined positions, writing the
+// result into target and returning its results, calculated in timestamp order as positionTester does.
+function merge(combined, candidate, target) {
+    var combinedIndex = 0;
+    var candidateIndex = 0;
+    var profitLoss = 0;
+    var winCount = 0;
+    var loseCount = 0;
+    var consecutiveLosses = 0;
+    var maximumConsecutiveLosses = 0;
+    var minimumProfitLoss = 99999;
+    var source = null;
+    var index = 0;
+    var investment = 0.0;
+    var positionProfitLoss = 0.0;
+
+    target.count = 0;
+
+    while (combinedIndex < combined.count || candidateIndex < candidate.count) {
+        // Positions already combined take precedence over candidate positions at the same timestamp.
+        if (candidateIndex >= candidate.count || (combinedIndex < combined.count && combined.timestamps[combinedIndex] <= candidate.timestamps[candidateIndex])) {
+            if (candidateIndex < candidate.count && combined.timestamps[combinedIndex] === candidate.timestamps[candidateIndex]) {
+                candidateIndex++;
+            }
+
+            source = combined;
+            index = combinedIndex++;
+        }
+        else {
+            source = candidate;
+            index = candidateIndex++;
+        }
+
+        investment = source.investments[index];
+        positionProfitLoss = source.profitLosses[index];
+
+        target.push(source.timestamps[index], investment, positionProfitLoss, source.positionIndexes[index]);
+
+        profitLoss -= investment;
+        profitLoss += positionProfitLoss;
+
+        if (positionProfitLoss > investment) {
+            winCount++;
+            consecutiveLosses = 0;
+        }
+        if (positionProfitLoss === 0) {
+            loseCount++;
+            consecutiveLosses++;
+        }
+
+        // Track minimum profit/loss.
+        if (positionProfitLoss < minimumProfitLoss) {
+            minimumProfitLoss = positionProfitLoss;
+        }
+
+        // Track the maximum consecutive losses.
+        if (consecutiveLosses > maximumConsecutiveLosses) {
+            maximumConsecutiveLosses = consecutiveLosses;
+        }
+    }
+
+    return {
+        profitLoss: profitLoss,
+        winCount: winCount,
+        loseCount: loseCount,
+        winRate: winCount + loseCount === 0 ? 0 : winCount / (winCount + loseCount),
+        tradeCount: winCount + loseCount,
+        maximumConsecutiveLosses: maximumConsecutiveLosses,
+        minimumProfitLoss: minimumProfitLoss
+    };
+}
+
+// Returns whether combined results are an improvement over the benchmark profit/loss.
+function isImprovement(results, benchmarkProfitLoss, requirements, tolerance) {
+    return results.profitLoss >= benchmarkProfitLoss + requirements.minimumImprovement - tolerance &&
+        results.winRate >= requirements.minimumWinRate &&
+        results.tradeCount >= requirements.minimumTradeCount &&
+        results.maximumConsecutiveLosses <= requirements.maximumConsecutiveLosses &&
+        results.minimumProfitLoss >= requirements.minimumProfitLoss;
+}
+
+// Combines the positions of candidates (objects with strategyUuid and configuration), tried in order.
+// positions includes the positions for all candidates. Returns the configurations and positions
+// combined.
+module.exports.combine = function(candidates, positions, requirements, progress) {
+    var positionArrays = groupPositions(positions);
+    var combined = new PositionArrays(positions.length);
+    var scratch = new PositionArrays(positions.length);
+    var temporary = null;
+    var totals = {
+        profitLoss: 0,
+        winCount: 0,
+        loseCount: 0,
+        minimumProfitLoss: 99999
+    };
+    var benchmarkProfitLoss = 0;
+    var configurations = [];
+    var combinedPositions = [];
+    var i = 0;
+
+    candidates.forEach(function(candidate, candidateIndex) {
+        var candidatePositions = positionArrays[candidate.strategyUuid] || new PositionArrays(0);
+        var estimate = {
+            profitLoss: totals.profitLoss,
+            winCount: totals.winCount,
+            loseCount: totals.loseCount,
+            minimumProfitLoss: totals.minimumProfitLoss,
+            maximumConsecutiveLosses: 0
+        };
+        var investment = 0.0;
+        var profitLoss = 0.0;
+        var results = null;
+        var j = 0;
+
+        if (progress) {
+            progress(candidateIndex, candidates.length, configurations.length, benchmarkProfitLoss);
+        }
+
+        // Add the new positions to the running totals.
+        for (j = 0; j < candidatePositions.count; j++) {
+            if (combined.hasTimestamp(candidatePositions.timestamps[j])) {
+                continue;
+            }
+
+            investment = candidatePositions.investments[j];
+            profitLoss = candidatePositions.profitLosses[j];
+
+            estimate.profitLoss += profitLoss - investment;
+
+            if (profitLoss > investment) {
+                estimate.winCount++;
+            }
+            if (profitLoss === 0) {
+                estimate.loseCount++;
+            }
+            if (profitLoss < estimate.minimumProfitLoss) {
+                estimate.minimumProfitLoss = profitLoss;
+            }
+        }
+
+        estimate.tradeCount = estimate.winCount + estimate.loseCount;
+        estimate.winRate = estimate.tradeCount ? estimate.winCount / estimate.tradeCount : 0;
+
+        // Consecutive losses can only be worked out by merging, so skip that check for now.
+        if (!isImprovement(estimate, benchmarkProfitLoss, requirements, Math.abs(estimate.profitLoss) * profitLossTolerance + profitLossTolerance)) {
+            return;
+        }
+
+        results = merge(combined, candidatePositions, scratch);
+
+        if (!isImprovement(results, benchmarkProfitLoss, requirements, 0)) {
+            return;
+        }
+
+        // Use the merged positions in future tests.
+        temporary = combined;
+        combined = scratch;
+        scratch = temporary;
+
+        totals.profitLoss = results.profitLoss;
+        totals.winCount = results.winCount;
+        totals.loseCount = results.loseCount;
+        totals.minimumProfitLoss = results.minimumProfitLoss;
+
+        // Include the candidate configuration in the list of combined configurations.
+        configurations.push(candidate.configuration);
+
+        // Update the benchmark.
+        benchmarkProfitLoss = results.profitLoss;
+    });
+
+    for (i = 0; i < combined.count; i++) {
+        combinedPositions.push(positions[combined.positionIndexes[i]]);
+    }
+
+    return {
+        configurations: configurations,
+        positions: combinedPositions
+    };
+};
@@ -0,0 +1,153 @@
+// Evaluates MongoDB-style query constraints, such as {winRate: {'$gte': 0.62}, tradeCount: {'$gte': 1000}},
+// against plain objects. This lets results be filtered with the same constraints used to query saved
+// backtests, before anything is saved.
+
+var operators = {
+    $eq: function(value, operand) {
+        return value === operand;
+    },
+    $ne: function(value, operand) {
+        return value !== operand;
+    },
+    $gt: function(value, operand) {
+        return value > operand;
+    },
+    $gte: function(value, operand) {
+        return value >= operand;
+    },
+    $lt: function(value, operand) {
+        return value < operand;
+    },
+    $lte: function(value, operand) {
+        return value <= operand;
+    },
+    $in: function(value, operand) {
+        return operand.indexOf(value) > -1;
+    },
+    $nin: function(value, operand) {
+        return operand.indexOf(value) === -1;
+    }
+};
+
+// Results that only ever increase, or only ever decrease, as a backtest goes on.
+var increasingResults = ['winCount', 'loseCount', 'tradeCount', 'maximumConsecutiveLosses'];
+var decreasingResults = ['minimumProfitLoss'];
+
+// Constraints backtest results must satisfy to be forward tested, unless others are given.
+module.exports.defaults = {
+    minimumProfitLoss: {'$gte': -20000},
+    maximumConsecutiveLosses: {'$lte': 10},
+    winRate: {'$gte': 0.62},
+    tradeCount: {'$gte': 1000}
+};
+
+// Returns whether a single field value satisfies its constraint.
+function matchesValue(value, constraint) {
+    var operator = '';
+
+    // Plain values must match exactly.
+    if (constraint === null || typeof constraint !== 'object' || constraint instanceof Array) {
+        return value === constraint;
+    }
+
+    for (operator in constraint) {
+        if (!operators[operator]) {
+            throw 'Unsupported constraint operator ' + operator + '.';
+        }
+        if (!operators[operator](value, constraint[operator])) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Returns whether the object satisfies every constraint.
+module.exports.matches = function(object, constraints) {
+    var key = '';
+
+    for (key in constraints) {
+        if (!matchesValue(object[key], constraints[key])) {
+            return false;
+        }
+    }
+
+    return true;
+};
+
+// Parses constraints given on the command line as JSON.
+module.exports.parse = function(json) {
+    var constraints = null;
+    var key = '';
+    var operator = '';
+
+    try {
+        constraints = JSON.parse(json);
+    }
+    catch (error) {
+        throw 'Invalid constraints: ' + (error.message || error);
+    }
+
+    if (!constraints || typeof constraints !== 'object' || constraints instanceof Array) {
+        throw 'Constraints must be an object.';
+    }
+
+    // Validate operators up front rather than part way through a run.
+    for (key in constraints) {
+        if (constraints[key] && typeof constraints[key] === 'object' && !(constraints[key] instanceof Array)) {
+            for (operator in constraints[key]) {
+                if (!operators[operator]) {
+                    throw 'Unsupported constraint operator ' + operator + '.';
+                }
+            }
+        }
+    }
+
+    return constraints;
+};
+
+// Returns rules for telling, part way through a backtest, that its results can never satisfy the
+// constraints: one for each upper limit on a result that only increases and each lower limit on a result
+// that only decreases, since once those are broken they stay broken. Limits on other results (such as the
+// win rate and profit/loss) can be recovered from, so they make no rules.
+module.exports.getPruningRules = function(constraints) {
+    var rules = [];
+    var key = '';
+    var constraint = null;
+    var operator = '';
+
+    for (key in constraints) {
+        constraint = constraints[key];
+
+        if (constraint === null || typeof constraint !== 'object' || constraint instanceof Array) {
+            constraint = {$eq: constraint};
+        }
+
+        for (operator in constraint) {
+            if (increasingResults.indexOf(key) > -1 && (operator === '$lte' || operator === '$lt' || operator === '$eq')) {
+                rules.push({key: key, operator: operator === '$eq' ? '$lte' : operator, operand: constraint[operator]});
+            }
+            else if (decreasingResults.indexOf(key) > -1 && (operator === '$gte' || operator === '$gt' || operator === '$eq')) {
+                rules.push({key: key, operator: operator === '$eq' ? '$gte' : operator, operand: constraint[operator]});
+            }
+        }
+    }
+
+    return rules;
+};
+
+// Returns whether results break any of the given pruning rules.
+module.exports.breaksPruningRules = function(results, rules) {
+    var rule = null;
+    var i = 0;
+
+    for (i = 0; i < rules.length; i++) {
+        rule = rules[i];
+
+        if (!operators[rule.operator](results[rule.key], rule.operand)) {
+            return true;
+        }
+    }
+
+    return false;
+};
@@ -1,50 +1,57 @@
-var fs = require('fs');
-var es = require('event-stream');
 var Q = require('q');
+var scanner = require('./scanner');
+
+// Lines are in the form timestamp,open,high,low,close, with millisecond timestamps.
+// The parser pushes each data point onto columns (anything with a push() like scanner.ColumnBuilder's), and
+// can be given lines one at a time, from scanner.scan() or a scanner.LineScanner.
+module.exports.createLineParser = function(columns) {
+    var parseNumber = scanner.parseNumber;
+
+    return function(buffer, starts, ends, fieldCount) {
+        var timestampLength = ends[0] - starts[0];
+        var timestamp = -1;
+
+        // Ignore blank lines.
+        if (fieldCount === 1 && timestampLength === 0) {
+            return;
+        }
+
+        if (timestampLength > 0 && timestampLength <= 15) {
+            timestamp = scanner.parseDigits(buffer, starts[0], timestampLength);
+        }
+        if (timestamp < 0) {
+            timestamp = parseInt(buffer.toString('ascii', starts[0], ends[0]));
+        }
+
+        columns.push(
+            timestamp,
+            0,
+            parseNumber(buffer, starts[1], ends[1]),
+            parseNumber(buffer, starts[2], ends[2]),
+            parseNumber(buffer, starts[3], ends[3]),
+            parseNumber(buffer, starts[4], ends[4])
+        );
+    };
+};
 
-module.exports.parse = function(filePath) {
+module.exports.parseColumns = function(filePath, onBatch) {
     var deferred = Q.defer();
-    var stream;
-
-    var transactionData = [];
-    var formattedData = [];
+    var columns = new scanner.ColumnBuilder(onBatch);
 
     if (!filePath) {
         throw 'No filePath provided to dataParser.'
     }
 
-    stream = fs.createReadStream(filePath)
-        .pipe(es.split())
-        .pipe(es.mapSync(function(line) {
-            // Pause the read stream.
-            stream.pause();
-
-            (function() {
-                // Ignore blank lines.
-                if (!line) {
-                    stream.resume();
-                    return;
-                }
-
-                transactionData = line.split(',');
-
-                formattedData.push({
-                    timestamp: parseInt(transactionData[0]),
-                    volume: 0,
-                    open: parseFloat(transactionData[1]),
-                    high: parseFloat(transactionData[2]),
-                    low: parseFloat(transactionData[3]),
-                    close: parseFloat(transactionData[4])
-                });
-
-                // Resume the read stream.
-                stream.resume();
-            })();
-        }));
-
-    stream.on('close', function() {
-        deferred.resolve(formattedData);
-    });
+    scanner.scan(filePath, module.exports.createLineParser(columns));
+
+    // Hand over the last data points, if parsing in batches.
+    columns.flush();
+
+    deferred.resolve(columns.getColumns());
 
     return deferred.promise;
 };
+
+module.exports.parse = function(filePath) {
+    return module.exports.parseColumns(filePath).then(scanner.toDataPoints);
+};
@@ -1,63 +1,85 @@
-var fs = require('fs');
-var es = require('event-stream');
 var Q = require('q');
+var scanner = require('./scanner');
 
-module.exports.parse = function(filePath) {
-    var deferred = Q.defer();
-    var stream;
+var PERIOD = 46;
+var SPACE = 32;
+var COLON = 58;
+
+// Lines are in the form 05.01.2015 00:00:00.000,open,high,low,close,volume (in local time), with a header line.
+// The parser pushes each data point onto columns (anything with a push() like scanner.ColumnBuilder's), and
+// can be given lines one at a time, from scanner.scan() or a scanner.LineScanner.
+module.exports.createLineParser = function(columns) {
+    var timeConverter = new scanner.LocalTimeConverter();
+    var parseNumber = scanner.parseNumber;
+    var parseDigits = scanner.parseDigits;
+
+    return function(buffer, starts, ends, fieldCount, lineIndex) {
+        var start = starts[0];
+        var volume = 0.0;
+        var timestamp = 0;
+
+        // Ignore blank lines.
+        if (fieldCount === 1 && starts[0] === ends[0]) {
+            return;
+        }
 
-    var transactionData = [];
-    var formattedData = [];
-    var index = -1;
-    var volume = 0.0;
+        // Skip the first line (being header data).
+        if (lineIndex === 0) {
+            return;
+        }
+
+        volume = parseNumber(buffer, starts[5], ends[5]);
+
+        if (!(volume > 0)) {
+            return;
+        }
+
+        if (ends[0] - start === 23 && buffer[start + 2] === PERIOD && buffer[start + 5] === PERIOD &&
+            buffer[start + 10] === SPACE && buffer[start + 13] === COLON && buffer[start + 16] === COLON && buffer[start + 19] === PERIOD) {
+            timestamp = timeConverter.convert(
+                parseDigits(buffer, start + 6, 4),
+                parseDigits(buffer, start + 3, 2),
+                parseDigits(buffer, start, 2),
+                parseDigits(buffer, start + 11, 2),
+                parseDigits(buffer, start + 14, 2),
+                parseDigits(buffer, start + 17, 2),
+                parseDigits(buffer, start + 20, 3)
+            );
+        }
+        else {
+            // Fall back to parsing other formats as dates.
+            timestamp = new Date(buffer.toString('ascii', start, ends[0]).replace(/(\d{2})\.(\d{2})\.(\d{4}) (.*)/, '$2-$1-$3 $4')).getTime();
+        }
+
+        columns.push(
+            timestamp,
+            volume,
+            parseNumber(buffer, starts[1], ends[1]),
+            parseNumber(buffer, starts[2], ends[2]),
+            parseNumber(buffer, starts[3], ends[3]),
+            parseNumber(buffer, starts[4], ends[4])
+        );
+    };
+};
+
+module.exports.parseColumns = function(filePath, onBatch) {
+    var deferred = Q.defer();
+    var columns = new scanner.ColumnBuilder(onBatch);
 
     if (!filePath) {
         throw 'No filePath provided to dataParser.'
     }
 
-    stream = fs.createReadStream(filePath)
-        .pipe(es.split())
-        .pipe(es.mapSync(function(line) {
-            // Pause the read stream.
-            stream.pause();
-
-            (function() {
-                index++;
-
-                // Ignore blank lines.
-                if (!line) {
-                    stream.resume();
-                    return;
-                }
-
-                // Skip the first line (being header data).
-                if (index === 0) {
-                    stream.resume();
-                    return;
-                }
-
-                transactionData = line.split(',');
-                volume = parseFloat(transactionData[5]);
-
-                if (volume > 0) {
-                    formattedData.push({
-                        timestamp: new Date(transactionData[0].replace(/(\d{2})\.(\d{2})\.(\d{4}) (.*)/, '$2-$1-$3 $4')).getTime(),
-                        volume: volume,
-                        open: parseFloat(transactionData[1]),
-                        high: parseFloat(transactionData[2]),
-                        low: parseFloat(transactionData[3]),
-                        close: parseFloat(transactionData[4])
-                    });
-                }
-
-                // Resume the read stream.
-                stream.resume();
-            })();
-        }));
-
-    stream.on('close', function() {
-        deferred.resolve(formattedData);
-    });
+    scanner.scan(filePath, module.exports.createLineParser(columns));
+
+    // Hand over the last data points, if parsing in batches.
+    columns.flush();
+
+    deferred.resolve(columns.getColumns());
 
     return deferred.promise;
 };
+
+module.exports.parse = function(filePath) {
+    return module.exports.parseColumns(filePath).then(scanner.toDataPoints);
+};
@@ -1,3 +1,5 @@
+// Each parser's parseColumns(filePath) resolves with typed array columns for the data file, or, given a
+// callback as well, hands the columns to it in batches as they are parsed.
 module.exports.dukascopy = require('./dukascopy');
 module.exports.metatrader = require('./metatrader');
 module.exports.ctoption = require('./ctoption');
@@ -1,54 +1,75 @@
 // Data source: http://www.fxdd.com/us/en/forex-resources/forex-trading-tools/metatrader-1-minute-data/
 
-var fs = require('fs');
-var es = require('event-stream');
 var Q = require('q');
+var scanner = require('./scanner');
 
-module.exports.parse = function(filePath) {
-    var deferred = Q.defer();
-    var stream;
+var PERIOD = 46;
+var COLON = 58;
+
+// Lines are in the form 2015.01.05,00:00,open,high,low,close,volume (in local time).
+// The parser pushes each data point onto columns (anything with a push() like scanner.ColumnBuilder's), and
+// can be given lines one at a time, from scanner.scan() or a scanner.LineScanner.
+module.exports.createLineParser = function(columns) {
+    var timeConverter = new scanner.LocalTimeConverter();
+    var parseNumber = scanner.parseNumber;
+    var parseDigits = scanner.parseDigits;
+
+    return function(buffer, starts, ends, fieldCount) {
+        var dateStart = starts[0];
+        var timeStart = starts[1];
+        var timestamp = 0;
+
+        // Ignore blank lines.
+        if (fieldCount === 1 && starts[0] === ends[0]) {
+            return;
+        }
+
+        if (ends[0] - dateStart === 10 && buffer[dateStart + 4] === PERIOD && buffer[dateStart + 7] === PERIOD &&
+            ends[1] - timeStart === 5 && buffer[timeStart + 2] === COLON) {
+            timestamp = timeConverter.convert(
+                parseDigits(buffer, dateStart, 4),
+                parseDigits(buffer, dateStart + 5, 2),
+                parseDigits(buffer, dateStart + 8, 2),
+                parseDigits(buffer, timeStart, 2),
+                parseDigits(buffer, timeStart + 3, 2),
+                0,
+                0
+            );
+        }
+        else {
+            // Fall back to parsing other formats as dates.
+            timestamp = new Date(buffer.toString('ascii', dateStart, ends[0]) + ' ' + buffer.toString('ascii', timeStart, ends[1]) + ':00').getTime();
+        }
+
+        columns.push(
+            timestamp,
+            parseNumber(buffer, starts[6], ends[6]),
+            parseNumber(buffer, starts[2], ends[2]),
+            parseNumber(buffer, starts[3], ends[3]),
+            parseNumber(buffer, starts[4], ends[4]),
+            parseNumber(buffer, starts[5], ends[5])
+        );
+    };
+};
 
-    var transactionData = [];
-    var formattedData = [];
-    var volume = 0.0;
+module.exports.parseColumns = function(filePath, onBatch) {
+    var deferred = Q.defer();
+    var columns = new scanner.ColumnBuilder(onBatch);
 
     if (!filePath) {
         throw 'No filePath provided to dataParser.'
     }
 
-    stream = fs.createReadStream(filePath)
-        .pipe(es.split())
-        .pipe(es.mapSync(function(line) {
-            // Pause the read stream.
-            stream.pause();
-
-            (function() {
-                // Ignore blank lines.
-                if (!line) {
-                    stream.resume();
-                    return;
-                }
-
-                transactionData = line.split(',');
-                volume = parseFloat(transactionData[6]);
-
-                formattedData.push({
-                    timestamp: new Date(transactionData[0] + ' ' + transactionData[1] + ':00').getTime(),
-                    volume: volume,
-                    open: parseFloat(transactionData[2]),
-                    high: parseFloat(transactionData[3]),
-                    low: parseFloat(transactionData[4]),
-                    close: parseFloat(transactionData[5])
-                });
-
-                // Resume the read stream.
-                stream.resume();
-            })();
-        }));
-
-    stream.on('close', function() {
-        deferred.resolve(formattedData);
-    });
+    scanner.scan(filePath, module.exports.createLineParser(columns));
+
+    // Hand over the last data points, if parsing in batches.
+    columns.flush();
+
+    deferred.resolve(columns.getColumns());
 
     return deferred.promise;
 };
+
+module.exports.parse = function(filePath) {
+    return module.exports.parseColumns(filePath).then(scanner.toDataPoints);
+};
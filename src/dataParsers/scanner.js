@@ -0,0 +1,334 @@
+// Shared helpers for parsing comma-separated data files. Files are read in chunks and scanned byte by byte,
+// and parsed values go straight into typed array columns rather than one object per data point.
+
+var fs = require('fs');
+var buffers = require('../buffers');
+
+// Number of bytes to read from disk at a time.
+var chunkSize = 4 * 1024 * 1024;
+
+// Maximum number of fields tracked per line.
+var maximumFieldCount = 16;
+
+// Initial number of rows allocated for columns.
+var initialCapacity = 65536;
+
+var columnNames = ['timestamp', 'volume', 'open', 'high', 'low', 'close'];
+
+// Powers of ten that can be represented exactly, for dividing out decimal places.
+var powersOfTen = [];
+(function() {
+    var i = 0;
+
+    for (i = 0; i <= 22; i++) {
+        powersOfTen[i] = Math.pow(10, i);
+    }
+})();
+
+var COMMA = 44;
+var NEWLINE = 10;
+var CARRIAGE_RETURN = 13;
+var MINUS = 45;
+var PLUS = 43;
+var PERIOD = 46;
+var ZERO = 48;
+var NINE = 57;
+
+// Finds the fields in the line from lineStart up to lineEnd, returning the number of fields.
+function splitFields(buffer, lineStart, lineEnd, fieldStarts, fieldEnds) {
+    var fieldCount = 0;
+    var position = 0;
+    var fieldIndex = 0;
+
+    fieldStarts[0] = lineStart;
+
+    // Ignore carriage returns from Windows line endings.
+    if (lineEnd > lineStart && buffer[lineEnd - 1] === CARRIAGE_RETURN) {
+        lineEnd--;
+    }
+
+    for (position = lineStart; position < lineEnd; position++) {
+        if (buffer[position] === COMMA && fieldCount < maximumFieldCount - 1) {
+            fieldEnds[fieldCount] = position;
+            fieldStarts[++fieldCount] = position + 1;
+        }
+    }
+    fieldEnds[fieldCount++] = lineEnd;
+
+    // Fields missing from the line are empty.
+    for (fieldIndex = fieldCount; fieldIndex < maximumFieldCount; fieldIndex++) {
+        fieldStarts[fieldIndex] = lineEnd;
+        fieldEnds[fieldIndex] = lineEnd;
+    }
+
+    return fieldCount;
+}
+
+// Calls onLine(buffer, fieldStarts, fieldEnds, fieldCount, lineIndex) for each line in the file. The field
+// offsets are only valid for the duration of the call, and fields beyond fieldCount are empty.
+module.exports.scan = function(filePath, onLine) {
+    var fileDescriptor = fs.openSync(filePath, 'r');
+    var buffer = buffers.alloc(chunkSize);
+    var fieldStarts = new Int32Array(maximumFieldCount);
+    var fieldEnds = new Int32Array(maximumFieldCount);
+    var bufferLength = 0;
+    var bytesRead = 0;
+    var lineStart = 0;
+    var scanPosition = 0;
+    var lineIndex = 0;
+    var byte = 0;
+    var temporary;
+    var done = false;
+
+    function emitLine(lineEnd) {
+        onLine(buffer, fieldStarts, fieldEnds, splitFields(buffer, lineStart, lineEnd, fieldStarts, fieldEnds), lineIndex++);
+    }
+
+    while (!done) {
+        // Move any partial line to the start of the buffer, growing the buffer if a line does not fit.
+        if (lineStart > 0) {
+            buffer.copy(buffer, 0, lineStart, bufferLength);
+            bufferLength -= lineStart;
+            lineStart = 0;
+        }
+        else if (bufferLength === buffer.length) {
+            temporary = buffers.alloc(buffer.length * 2);
+            buffer.copy(temporary, 0, 0, bufferLength);
+            buffer = temporary;
+        }
+
+        bytesRead = fs.readSync(fileDescriptor, buffer, bufferLength, buffer.length - bufferLength, null);
+        done = bytesRead === 0;
+
+        // Scan only the newly read bytes for line endings.
+        for (scanPosition = bufferLength, bufferLength += bytesRead; scanPosition < bufferLength; scanPosition++) {
+            byte = buffer[scanPosition];
+
+            if (byte === NEWLINE) {
+                emitLine(scanPosition);
+                lineStart = scanPosition + 1;
+            }
+        }
+    }
+
+    // Handle a last line with no line ending.
+    if (lineStart < bufferLength) {
+        emitLine(bufferLength);
+    }
+
+    fs.closeSync(fileDescriptor);
+};
+
+// Scans lines from data that arrives a piece at a time (such as from a file being appended to, or a socket),
+// calling onLine as scan() does for each complete line. Lines are numbered from firstLineIndex.
+function LineScanner(onLine, firstLineIndex) {
+    this.onLine = onLine;
+    this.lineIndex = firstLineIndex || 0;
+    this.pending = null;
+    this.fieldStarts = new Int32Array(maximumFieldCount);
+    this.fieldEnds = new Int32Array(maximumFieldCount);
+}
+
+LineScanner.prototype.write = function(data) {
+    var buffer = this.pending ? Buffer.concat([this.pending, data]) : data;
+    var lineStart = 0;
+    var position = 0;
+
+    for (position = 0; position < buffer.length; position++) {
+        if (buffer[position] === NEWLINE) {
+            this.onLine(buffer, this.fieldStarts, this.fieldEnds, splitFields(buffer, lineStart, position, this.fieldStarts, this.fieldEnds), this.lineIndex++);
+            lineStart = position + 1;
+        }
+    }
+
+    // Keep a copy of any partial line until the rest of it arrives, since the data may be reused.
+    this.pending = null;
+    if (lineStart < buffer.length) {
+        this.pending = buffers.alloc(buffer.length - lineStart);
+        buffer.copy(this.pending, 0, lineStart);
+    }
+};
+
+module.exports.LineScanner = LineScanner;
+
+// Parses a decimal number, giving the same result as parseFloat() would.
+module.exports.parseNumber = function(buffer, start, end) {
+    var mantissa = 0;
+    var digitCount = 0;
+    var decimalCount = 0;
+    var negative = false;
+    var seenPeriod = false;
+    var position = start;
+    var byte = 0;
+
+    if (position < end && (buffer[position] === MINUS || buffer[position] === PLUS)) {
+        negative = buffer[position] === MINUS;
+        position++;
+    }
+
+    for (; position < end; position++) {
+        byte = buffer[position];
+
+        if (byte >= ZERO && byte <= NINE) {
+            mantissa = mantissa * 10 + (byte - ZERO);
+            digitCount++;
+
+            if (seenPeriod) {
+                decimalCount++;
+            }
+        }
+        else if (byte === PERIOD && !seenPeriod) {
+            seenPeriod = true;
+        }
+        else {
+            break;
+        }
+    }
+
+    // Integers with up to 15 digits and up to 22 decimal places are exact, and so dividing gives a
+    // correctly rounded result. Anything else (exponents, long numbers, etc.) is left to parseFloat().
+    if (position !== end || digitCount === 0 || digitCount > 15 || decimalCount > 22) {
+        return parseFloat(buffer.toString('ascii', start, end));
+    }
+
+    mantissa = decimalCount ? mantissa / powersOfTen[decimalCount] : mantissa;
+
+    return negative ? -mantissa : mantissa;
+};
+
+// Parses a fixed-width run of digits, returning -1 if any character is not a digit.
+module.exports.parseDigits = function(buffer, start, length) {
+    var value = 0;
+    var byte = 0;
+    var position = 0;
+
+    for (position = start; position < start + length; position++) {
+        byte = buffer[position];
+
+        if (byte < ZERO || byte > NINE) {
+            return -1;
+        }
+        value = value * 10 + (byte - ZERO);
+    }
+
+    return value;
+};
+
+// Converts local date and time parts into a timestamp. The start of each hour is cached, since consecutive
+// data points almost always fall within the same hour.
+function LocalTimeConverter() {
+    this.hourKey = -1;
+    this.hourTimestamp = 0;
+}
+
+LocalTimeConverter.prototype.convert = function(year, month, day, hour, minute, second, millisecond) {
+    var hourKey = ((year * 100 + month) * 100 + day) * 100 + hour;
+
+    if (hourKey !== this.hourKey) {
+        this.hourKey = hourKey;
+        this.hourTimestamp = new Date(year, month - 1, day, hour).getTime();
+    }
+
+    return this.hourTimestamp + minute * 60000 + second * 1000 + millisecond;
+};
+
+module.exports.LocalTimeConverter = LocalTimeConverter;
+
+// Collects parsed data points into typed array columns, growing them as needed. If onBatch is given, the
+// columns are instead handed to it each time they fill up (and when flushed), so that memory use does not
+// depend on the length of the data.
+function ColumnBuilder(onBatch) {
+    var self = this;
+
+    self.length = 0;
+    self.capacity = initialCapacity;
+    self.columns = {};
+    self.onBatch = onBatch || null;
+
+    columnNames.forEach(function(columnName) {
+        self.columns[columnName] = new Float64Array(self.capacity);
+    });
+}
+
+ColumnBuilder.prototype.push = function(timestamp, volume, open, high, low, close) {
+    var columns = this.columns;
+    var index = this.length;
+
+    if (index === this.capacity) {
+        if (this.onBatch) {
+            this.flush();
+            index = 0;
+        }
+        else {
+            this.grow();
+            columns = this.columns;
+        }
+    }
+
+    columns.timestamp[index] = timestamp;
+    columns.volume[index] = volume;
+    columns.open[index] = open;
+    columns.high[index] = high;
+    columns.low[index] = low;
+    columns.close[index] = close;
+
+    this.length++;
+};
+
+ColumnBuilder.prototype.grow = function() {
+    var self = this;
+
+    self.capacity *= 2;
+
+    columnNames.forEach(function(columnName) {
+        var values = new Float64Array(self.capacity);
+
+        values.set(self.columns[columnName]);
+        self.columns[columnName] = values;
+    });
+};
+
+// Returns the columns, trimmed to the number of data points.
+ColumnBuilder.prototype.getColumns = function() {
+    var self = this;
+    var columns = {
+        length: self.length
+    };
+
+    columnNames.forEach(function(columnName) {
+        columns[columnName] = new Float64Array(self.columns[columnName].subarray(0, self.length));
+    });
+
+    return columns;
+};
+
+// Hands the data points collected so far to the batch callback, if any, and starts over.
+ColumnBuilder.prototype.flush = function() {
+    if (!this.onBatch || !this.length) {
+        return;
+    }
+
+    this.onBatch(this.getColumns());
+    this.length = 0;
+};
+
+module.exports.ColumnBuilder = ColumnBuilder;
+
+// Converts columns into an array of data point objects.
+module.exports.toDataPoints = function(columns) {
+    var dataPoints = [];
+    var i = 0;
+
+    for (i = 0; i < columns.length; i++) {
+        dataPoints[i] = {
+            timestamp: columns.timestamp[i],
+            volume: columns.volume[i],
+            open: columns.open[i],
+            high: columns.high[i],
+            low: columns.low[i],
+            close: columns.close[i]
+        };
+    }
+
+    return dataPoints;
+};
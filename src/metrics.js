@@ -0,0 +1,165 @@
+var fs = require('fs');
+var path = require('path');
+
+// Metrics for the current process: wall and CPU time per phase, counters, gauges (such as queue depths),
+// and latencies (such as database inserts). Worker processes send snapshots of their metrics to the
+// process that started them, which keeps the latest snapshot for each worker.
+
+var phases = {};
+var counters = {};
+var gauges = {};
+var latencies = {};
+var workers = {};
+var startTime = Date.now();
+var reportingInterval = null;
+var reportingFilePath = '';
+
+// CPU time in milliseconds, where the version of Node.js supports measuring it.
+function getCpuTime() {
+    var usage = null;
+
+    if (!process.cpuUsage) {
+        return 0;
+    }
+
+    usage = process.cpuUsage();
+
+    return (usage.user + usage.system) / 1000;
+}
+
+// Starts timing a phase, returning a function that stops timing it. Phases may be timed more than once,
+// and their times add up.
+module.exports.time = function(phaseName) {
+    var wallStartTime = process.hrtime();
+    var cpuStartTime = getCpuTime();
+
+    return function() {
+        var elapsed = process.hrtime(wallStartTime);
+        var phase = phases[phaseName];
+
+        if (!phase) {
+            phase = phases[phaseName] = {
+                count: 0,
+                wallTime: 0,
+                cpuTime: 0
+            };
+        }
+
+        phase.count++;
+        phase.wallTime += elapsed[0] * 1000 + elapsed[1] / 1e6;
+        phase.cpuTime += getCpuTime() - cpuStartTime;
+    };
+};
+
+module.exports.increment = function(counterName, count) {
+    counters[counterName] = (counters[counterName] || 0) + (count === undefined ? 1 : count);
+};
+
+module.exports.setGauge = function(gaugeName, value) {
+    gauges[gaugeName] = value;
+};
+
+module.exports.recordLatency = function(latencyName, milliseconds) {
+    var latency = latencies[latencyName];
+
+    if (!latency) {
+        latency = latencies[latencyName] = {
+            count: 0,
+            totalTime: 0,
+            maximumTime: 0
+        };
+    }
+
+    latency.count++;
+    latency.totalTime += milliseconds;
+    latency.maximumTime = Math.max(latency.maximumTime, milliseconds);
+};
+
+// Wraps a Node.js-style callback so that the time until it is called is recorded as a latency.
+module.exports.timeCallback = function(latencyName, callback) {
+    var callbackStartTime = Date.now();
+
+    return function() {
+        module.exports.recordLatency(latencyName, Date.now() - callbackStartTime);
+        callback.apply(this, arguments);
+    };
+};
+
+// Keeps the latest metrics snapshot sent by a worker.
+module.exports.setWorkerSnapshot = function(workerName, snapshot) {
+    workers[workerName] = snapshot;
+};
+
+// Returns the metrics for this process (and any of its workers) as a plain object.
+module.exports.snapshot = function() {
+    var memoryUsage = process.memoryUsage();
+    var uptime = (Date.now() - startTime) / 1000;
+    var rates = {};
+    var counterName = '';
+
+    // Report counters (bars backtested and so on) per second as well.
+    for (counterName in counters) {
+        rates[counterName] = uptime ? counters[counterName] / uptime : 0;
+    }
+
+    return {
+        time: new Date().toISOString(),
+        pid: process.pid,
+        uptime: uptime,
+        memory: {
+            rss: memoryUsage.rss,
+            heapTotal: memoryUsage.heapTotal,
+            heapUsed: memoryUsage.heapUsed
+        },
+        phases: phases,
+        counters: counters,
+        rates: rates,
+        gauges: gauges,
+        latencies: latencies,
+        workers: workers
+    };
+};
+
+module.exports.reset = function() {
+    phases = {};
+    counters = {};
+    gauges = {};
+    latencies = {};
+    workers = {};
+    startTime = Date.now();
+};
+
+// Appends a snapshot as one line of JSON to the metrics log, if reporting.
+module.exports.report = function() {
+    if (!reportingFilePath) {
+        return;
+    }
+
+    fs.appendFileSync(reportingFilePath, JSON.stringify(module.exports.snapshot()) + '\n');
+};
+
+// Starts appending snapshots to a log file periodically.
+module.exports.startReporting = function(filePath, interval) {
+    var directory = path.dirname(filePath);
+
+    if (!fs.existsSync(directory)) {
+        fs.mkdirSync(directory);
+    }
+
+    reportingFilePath = filePath;
+    reportingInterval = setInterval(module.exports.report, interval);
+
+    // Do not keep the process alive just to report.
+    if (reportingInterval.unref) {
+        reportingInterval.unref();
+    }
+};
+
+// Stops reporting, appending one last snapshot.
+module.exports.stopReporting = function() {
+    clearInterval(reportingInterval);
+    module.exports.report();
+
+    reportingInterval = null;
+    reportingFilePath = '';
+};
@@ -5,13 +5,17 @@ var backtestSchema = mongoose.Schema({
     strategyUuid: {type: String, required: true},
     strategyName: {type: String, required: true},
     configuration: {type: mongoose.Schema.Types.Mixed, required: true},
+    configurationHash: {type: String},
     profitLoss: {type: Number, required: true},
     winCount: {type: Number, required: true},
     loseCount: {type: Number, required: true},
     tradeCount: {type: Number, required: true},
     winRate: {type: Number, required: true},
     maximumConsecutiveLosses: {type: Number, required: true},
-    minimumProfitLoss: {type: Number, required: true}
+    minimumProfitLoss: {type: Number, required: true},
+    pruned: {type: Boolean},
+    inSampleStart: {type: Number},
+    inSampleEnd: {type: Number}
 });
 
 module.exports = mongoose.connection.model('Backtest', backtestSchema);
@@ -1,6 +1,8 @@
 var mongoose = require('mongoose');
 
 var positionSchema = mongoose.Schema({
+    // Positions have deterministic IDs (see Ledger.takeExpiredDocuments).
+    _id: {type: String},
     symbol: {type: String, required: true},
     strategyUuid: {type: String, required: true},
     transactionType: {type: String, required: true},
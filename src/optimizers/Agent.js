@@ -0,0 +1,297 @@
+var fs = require('fs');
+var os = require('os');
+var url = require('url');
+var http = require('http');
+var path = require('path');
+var _ = require('lodash');
+var forkFn = require('child_process').fork;
+var ColumnStore = require('../ColumnStore');
+var Checkpoint = require('../Checkpoint');
+var metrics = require('../metrics');
+var progress = require('../progress');
+
+// Number of milliseconds to wait before retrying a request the coordinator did not respond to.
+var retryDelay = 5000;
+
+// Number of consecutive failed requests after which the coordinator is assumed to be gone.
+var maximumRetryCount = 60;
+
+// Backtests configurations leased from a coordinator (see Coordinator.js) using local worker forks. The
+// prepared data is downloaded from the coordinator once and kept under ./data/prepared/ like data prepared
+// locally, and positions are saved to the coordinator's database.
+function Agent(coordinatorUrl, workerCount, databaseHost) {
+    this.coordinatorUrl = url.parse(coordinatorUrl);
+    this.workerCount = workerCount || os.cpus().length;
+    this.databaseHost = databaseHost || this.coordinatorUrl.hostname;
+    this.settings = null;
+    this.manifest = null;
+    this.leaseTimeout = 0;
+    this.store = null;
+}
+
+Agent.prototype.getWorkerId = function(workerIndex) {
+    return os.hostname() + ':' + process.pid + '/' + workerIndex;
+};
+
+// Sends a JSON request to the coordinator, retrying while it cannot be reached. Calls back with the status
+// code and response data.
+Agent.prototype.request = function(method, requestPath, data, callback) {
+    var self = this;
+    var body = data ? JSON.stringify(data) : '';
+    var retryCount = 0;
+
+    function send() {
+        var request = http.request({
+            hostname: self.coordinatorUrl.hostname,
+            port: self.coordinatorUrl.port,
+            method: method,
+            path: requestPath,
+            headers: {
+                'Content-Type': 'application/json',
+                'Content-Length': Buffer.byteLength(body)
+            }
+        }, function(response) {
+            var responseBody = '';
+
+            response.setEncoding('utf8');
+            response.on('data', function(data) {
+                responseBody += data;
+            });
+            response.on('end', function() {
+                var responseData = {};
+
+                try {
+                    responseData = JSON.parse(responseBody);
+                }
+                catch (error) {
+                    // Use an empty response.
+                }
+
+                callback(response.statusCode, responseData);
+            });
+        });
+
+        request.on('error', function(error) {
+            if (++retryCount > maximumRetryCount) {
+                throw 'Could not reach coordinator: ' + (error.message || error);
+            }
+
+            setTimeout(send, retryDelay);
+        });
+
+        request.end(body);
+    }
+
+    send();
+};
+
+// Downloads a column file from the coordinator, replacing the local file only once it is complete.
+Agent.prototype.downloadColumn = function(columnName, callback) {
+    var self = this;
+    var filePath = self.store.getColumnPath(columnName);
+
+    http.get({
+        hostname: self.coordinatorUrl.hostname,
+        port: self.coordinatorUrl.port,
+        path: '/store/' + encodeURIComponent(columnName)
+    }, function(response) {
+        var file = null;
+
+        if (response.statusCode !== 200) {
+            throw 'Could not download column ' + columnName + ' from coordinator.';
+        }
+
+        file = fs.createWriteStream(filePath + '.download');
+        file.on('finish', function() {
+            fs.renameSync(filePath + '.download', filePath);
+            callback();
+        });
+        response.pipe(file);
+    }).on('error', function(error) {
+        throw 'Could not download column ' + columnName + ' from coordinator: ' + (error.message || error);
+    });
+};
+
+// Makes the local copy of the prepared data store match the coordinator's, downloading only columns that
+// are missing or were produced by a different study.
+Agent.prototype.synchronizeStore = function(callback) {
+    var self = this;
+    var manifest = self.manifest;
+    var localManifest = null;
+    var studies = manifest.studies || {};
+    var columnNames = [];
+    var showProgress = progress.create(28);
+    var stopTimer = null;
+
+    self.store = new ColumnStore(path.join(__dirname, '..', '..', 'data', 'prepared', self.settings.symbol, path.basename(self.settings.storeDirectory)));
+    localManifest = self.store.load();
+
+    columnNames = manifest.columns.filter(function(columnName) {
+        return !localManifest || localManifest.count !== manifest.count || !self.store.hasColumn(columnName) || self.store.getStudyKey(columnName) !== studies[columnName];
+    });
+
+    if (!columnNames.length) {
+        callback();
+        return;
+    }
+
+    ColumnStore.makeDirectory(self.store.getDirectory());
+
+    process.stdout.write('Downloading prepared data...');
+    stopTimer = metrics.time('downloadStore');
+
+    function next(index) {
+        showProgress(index + ' of ' + columnNames.length + ' columns completed', index === columnNames.length);
+
+        if (index === columnNames.length) {
+            process.stdout.write('\n');
+            stopTimer();
+
+            // Only record the columns once all of their data has been downloaded.
+            self.store.setManifest(manifest);
+
+            callback();
+            return;
+        }
+
+        self.downloadColumn(columnNames[index], function() {
+            next(index + 1);
+        });
+    }
+
+    next(0);
+};
+
+// Leases chunks for a worker fork until the coordinator has none left.
+Agent.prototype.runWorker = function(workerIndex, callback) {
+    var self = this;
+    var workerId = self.getWorkerId(workerIndex);
+    var fork = null;
+    var lease = null;
+    var renewalInterval = null;
+    var chunkStartTime = 0;
+
+    function startFork() {
+        var chunkFork = forkFn(__dirname + '/worker.js');
+
+        chunkFork.on('message', function(message) {
+            // Ignore a fork that was stopped after its lease expired.
+            if (message.type !== 'chunkDone' || chunkFork !== fork) {
+                return;
+            }
+
+            clearInterval(renewalInterval);
+            metrics.recordLatency('chunkRoundTrip', Date.now() - chunkStartTime);
+            metrics.setWorkerSnapshot(workerId, message.data.metrics);
+
+            lease.done = true;
+
+            self.request('POST', '/leases/' + lease.id + '/results', _.extend({
+                workerId: workerId,
+                chunkIndex: lease.chunkIndex
+            }, message.data), metrics.timeCallback('postResults', function() {
+                lease = null;
+                requestLease();
+            }));
+        });
+
+        chunkFork.send({
+            type: 'init',
+            data: _.extend({}, self.settings, {
+                storeDirectory: self.store.getDirectory(),
+                databaseHost: self.databaseHost,
+                checkpointDirectory: self.getCheckpoint().getDirectory(),
+                checkpointName: self.settings.runName + '_' + os.hostname() + '_' + workerIndex
+            })
+        });
+
+        fork = chunkFork;
+    }
+
+    // Stops backtesting a chunk whose lease has expired (the coordinator has or will give the chunk to
+    // another worker, and would drop the results as duplicates), and leases another with a new fork.
+    function abandonLease() {
+        clearInterval(renewalInterval);
+        lease = null;
+
+        fork.kill();
+        startFork();
+        requestLease();
+    }
+
+    function requestLease() {
+        self.request('POST', '/leases', {workerId: workerId}, function(statusCode, data) {
+            var renewedLease = null;
+
+            if (data.done) {
+                fork.kill();
+                callback();
+                return;
+            }
+
+            if (!data.lease) {
+                setTimeout(requestLease, data.wait || retryDelay);
+                return;
+            }
+
+            renewedLease = lease = data.lease;
+            chunkStartTime = Date.now();
+
+            // Keep the lease while the chunk is being backtested.
+            renewalInterval = setInterval(function() {
+                self.request('POST', '/leases/' + renewedLease.id + '/renew', null, function(statusCode) {
+                    // Leases end once results are posted, so only a lease still being backtested has expired.
+                    if (statusCode === 410 && lease === renewedLease && !renewedLease.done) {
+                        abandonLease();
+                    }
+                });
+            }, Math.max(Math.floor(self.leaseTimeout / 3), 1000));
+
+            fork.send({type: 'chunk', data: {configurationRanges: lease.configurationRanges}});
+        });
+    }
+
+    startFork();
+    requestLease();
+};
+
+// Checkpoints are kept locally, so a chunk leased again by this agent after an interruption continues from
+// where it left off.
+Agent.prototype.getCheckpoint = function() {
+    return new Checkpoint(path.join(this.store.getDirectory(), 'checkpoints', this.settings.strategyName));
+};
+
+Agent.prototype.run = function(callback) {
+    var self = this;
+
+    self.request('GET', '/settings', null, function(statusCode, data) {
+        if (statusCode !== 200 || !data.settings) {
+            throw 'Invalid settings received from coordinator.';
+        }
+
+        self.settings = data.settings;
+        self.manifest = data.manifest;
+        self.leaseTimeout = data.leaseTimeout;
+
+        self.synchronizeStore(function() {
+            var doneCount = 0;
+            var workerIndex = 0;
+
+            process.stdout.write('Backtesting with ' + self.workerCount + ' workers...\n');
+
+            for (workerIndex = 0; workerIndex < self.workerCount; workerIndex++) {
+                self.runWorker(workerIndex, function() {
+                    if (++doneCount < self.workerCount) {
+                        return;
+                    }
+
+                    // The run is complete.
+                    self.getCheckpoint().clear();
+                    callback();
+                });
+            }
+        });
+    });
+};
+
+module.exports = Agent;
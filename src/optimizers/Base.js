@@ -1,362 +1,447 @@
 var _ = require('lodash');
 var async = require('async');
+var path = require('path');
 var forkFn = require('child_process').fork;
 var Backtest = require('../models/Backtest');
-var DataPoint = require('../models/DataPoint');
+var StudyCache = require('../StudyCache');
+var Checkpoint = require('../Checkpoint');
+var ConfigurationSpace = require('../ConfigurationSpace');
+var Coordinator = require('./Coordinator');
+var WriteBuffer = require('../WriteBuffer');
+var metrics = require('../metrics');
+var progress = require('../progress');
 var strategyFns = require('../strategies');
 
 require('events').EventEmitter.defaultMaxListeners = Infinity;
 
+// Guided scheduling hands out chunks of about (remaining configurations) / (forks * chunksPerFork), but no
+// fewer than minimumChunkSize configurations so that forks still share signals across configurations.
+var chunksPerFork = 2;
+var minimumChunkSize = 4;
+
 function Base(strategyName, symbol) {
     this.strategyName = strategyName;
     this.symbol = symbol;
-    this.studies = [];
-}
-
-Base.prototype.prepareStudies = function(studyDefinitions) {
-    var self = this;
+    this.studyDefinitions = [];
 
-    // Iterate over each study definition...
-    process.stdout.write('Preparing studies...');
-    studyDefinitions.forEach(function(studyDefinition) {
-        // Instantiate the study, and add it to the list of studies for this strategy.
-        self.studies.push(new studyDefinition.study(studyDefinition.inputs, studyDefinition.outputMap));
-    });
-    process.stdout.write('done\n');
-};
-
-Base.prototype.prepareStudyData = function(data, callback) {
-    var self = this;
-    var percentage = 0.0;
-    var dataPointCount = data.length;
-
-    process.stdout.write('Preparing data for studies...');
+    // Prepared data is stored in columnar form on disk once the data file is known.
+    this.store = null;
 
-    // Find cached data points, if any.
-    DataPoint.count({symbol: self.symbol}, function(error, count) {
-        if (error) {
-            console.error(error.message || error);
-        }
-        if (count > 0) {
-            process.stdout.write('using cached data\n');
-            callback();
-            return;
-        }
-
-        var cumulativeData = [];
-        var previousDataPoint = null;
-
-        var prepareDataPoint = function(dataPoint, index, taskCallback) {
-            var completedDataPoints = [];
-
-            percentage = ((index / dataPointCount) * 100).toFixed(5);
-            process.stdout.cursorTo(29);
-            process.stdout.write(percentage + '%');
-
-            // If there is a significant gap, save the current data points, and start over with recording.
-            if (previousDataPoint && (dataPoint.timestamp - previousDataPoint.timestamp) > 65 * 1000) {
-                self.saveDataPoints(cumulativeData.slice());
-                cumulativeData = [];
-            }
+    // In aggregate-only mode, only results are kept during the run, and positions are saved afterwards
+    // only for backtests that satisfy the position constraints (if any), a chunk at a time.
+    this.aggregateOnly = false;
+    this.positionConstraints = null;
 
-            // Add the data point (cloned) to the cumulative data.
-            cumulativeData.push(dataPoint);
+    // When coordinating, configurations are backtested by remote agents rather than local forks.
+    this.coordinator = null;
 
-            // Iterate over each study...
-            self.studies.forEach(function(study) {
-                var studyProperty = '';
-                var studyTickValues = {};
-                var studyOutputs = study.getOutputMappings();
+    // Forks shared with other optimizers, for batch runs. Otherwise forks are created for each run.
+    this.sharedForks = null;
 
-                // Update the data for the study.
-                study.setData(cumulativeData);
+    // Write concern for inserting backtests and positions (see WriteBuffer).
+    this.writeConcern = undefined;
 
-                studyTickValues = study.tick();
+    // Backtests that can no longer satisfy these constraints are stopped part way through and saved as
+    // pruned (see constraints.getPruningRules()).
+    this.pruningConstraints = null;
 
-                // Augment the last data point with the data the study generates.
-                for (studyProperty in studyOutputs) {
-                    if (studyTickValues && typeof studyTickValues[studyOutputs[studyProperty]] === 'number') {
-                        dataPoint[studyOutputs[studyProperty]] = studyTickValues[studyOutputs[studyProperty]];
-                    }
-                    else {
-                        dataPoint[studyOutputs[studyProperty]] = '';
-                    }
-                }
-
-                // Ensure memory is freed.
-                studyTickValues = null;
-            });
-
-            previousDataPoint = dataPoint;
+    // When walk-forward testing (see walkForward.js), only the in-sample part of a window of the prepared
+    // data is optimized, and backtests are saved with the window's in-sample period.
+    this.window = null;
+}
 
-            // Periodically free up memory.
-            if (cumulativeData.length >= 2000) {
-                // Remove a chunk of completed items from the cumulative data.
-                completedDataPoints = cumulativeData.splice(0, 1000);
+Base.prototype.setForks = function(forks) {
+    this.sharedForks = forks;
+};
 
-                // Save the data just removed prior to derefrencing it.
-                self.saveDataPoints(completedDataPoints, function() {
-                    // Explicitly mark each item as ready for garbage collection, and then the whole array.
-                    completedDataPoints.forEach(function(item, index) {
-                        completedDataPoints[index] = null;
-                    });
-                    completedDataPoints = [];
+Base.prototype.setCoordinator = function(port, leaseTimeout) {
+    this.coordinator = new Coordinator(port, leaseTimeout);
+};
 
-                    taskCallback();
-                });
-            }
-            else {
-                taskCallback();
-            }
-        };
+Base.prototype.setAggregateOnly = function(positionConstraints) {
+    this.aggregateOnly = true;
+    this.positionConstraints = positionConstraints || null;
+};
 
-        var tasks = [];
+Base.prototype.setWriteConcern = function(writeConcern) {
+    this.writeConcern = writeConcern;
+};
 
-        data.forEach(function(dataPoint, index) {
-            tasks.push(function(taskCallback) {
-                prepareDataPoint(_.clone(dataPoint), index, taskCallback);
-            });
-        });
-        async.series(tasks, function(error) {
-            if (error) {
-                console.error(error.message || error);
-            }
+Base.prototype.setPruning = function(pruningConstraints) {
+    this.pruningConstraints = pruningConstraints;
+};
 
-            // Save the data just removed prior to derefrencing it.
-            self.saveDataPoints(cumulativeData, function() {
-                data = [];
-                cumulativeData = [];
-                self.studies = [];
+// Optimizes only the data points from window.start up to window.end, which are those from
+// window.inSampleStart up to window.inSampleEnd (timestamps). A null window optimizes all prepared data.
+Base.prototype.setWindow = function(window) {
+    this.window = window;
+};
 
-                process.stdout.cursorTo(29);
-                process.stdout.write((100).toFixed(5) + '%\n');
+Base.prototype.prepareStudies = function(studyDefinitions) {
+    // Studies are instantiated only if their data is not already cached.
+    this.studyDefinitions = studyDefinitions;
+};
 
-                // Done preparing study data.
-                callback();
-            });
-        });
-    });
+Base.prototype.getStudyCache = function(dataFilePath) {
+    return new StudyCache(this.symbol, dataFilePath, 65 * 1000);
 };
 
-Base.prototype.saveDataPoints = function(data, callback) {
+Base.prototype.prepareStudyData = function(dataParser, dataFilePath, callback) {
     var self = this;
-    callback = callback || function() {};
+    var studyCache = self.getStudyCache(dataFilePath);
+    var showProgress = progress.create(29);
+    var stopTimer = metrics.time('prepareStudyData');
+
+    self.store = studyCache.getStore();
 
-    if (!data || !data.length) {
+    process.stdout.write('Preparing data for studies...');
+
+    // Use cached data, if all of it is available.
+    if (!studyCache.getMissingDefinitions(self.studyDefinitions).length) {
+        process.stdout.write('using cached data\n');
+        stopTimer();
         callback();
         return;
     }
 
-    var dataPoints = _.map(data, function(dataPoint) {
-        return {
-            symbol: self.symbol,
-            data: dataPoint
-        }
-    });
-    DataPoint.collection.insert(dataPoints, function() {
-        dataPoints = [];
-        callback();
+    // Compute only the studies that are not cached, starting the cumulative data for studies over wherever
+    // there is a significant gap.
+    studyCache.prepare(self.studyDefinitions, dataParser, function(dataPointCount, done) {
+        showProgress(dataPointCount + ' data points completed', done);
+    }, function(error) {
+        process.stdout.write('\n');
+        stopTimer();
+
+        // Done preparing study data, unless it could not be prepared.
+        callback(error);
     });
 };
 
-Base.prototype.buildConfigurations = function(options, optionIndex, results, current) {
-    if (!optionIndex) {
-        process.stdout.write('Building configurations...');
-    }
-
-    optionIndex = optionIndex || 0;
-    results = results || [];
-    current = current || {};
-
-    var allKeys = Object.keys(options);
-    var optionKey = allKeys[optionIndex];
-    var vals = options[optionKey];
-    var i = 0;
+Base.prototype.buildConfigurationSpace = function(options) {
+    return new ConfigurationSpace(options);
+};
 
-    for (i = 0; i < vals.length; i++) {
-        current[optionKey] = vals[i];
+// Calls back with the index ranges of configurations in the space not already used in completed backtests.
+Base.prototype.findRemainingConfigurations = function(configurationSpace, callback) {
+    var query = {symbol: this.symbol};
 
-        if (optionIndex + 1 < allKeys.length) {
-            this.buildConfigurations(options, optionIndex + 1, results, current);
-        }
-        else {
-            results.push(JSON.parse(JSON.stringify(current)));
-        }
+    // Backtests over a window only count for that window, and ones over all of the data only for runs
+    // over all of the data.
+    if (this.window) {
+        query.inSampleStart = this.window.inSampleStart;
+        query.inSampleEnd = this.window.inSampleEnd;
     }
-
-    if (!optionIndex) {
-        process.stdout.write('done\n');
+    else {
+        query.inSampleStart = {'$exists': false};
     }
 
-    return results;
-};
+    Backtest.find(query, {configurationHash: 1, configuration: 1}, metrics.timeCallback('mongo.find.backtests', function(error, backtests) {
+        var completedIndexes = [];
+        var completedHashes = null;
 
-Base.prototype.removeCompletedConfigurations = function(configurations, callback) {
-    Backtest.find({symbol: this.symbol}, function(error, backtests) {
         if (error) {
             console.error(error.message || error);
         }
 
-        // Get the configurations for completed backtests.
-        var completedConfigurations = _.map(backtests, function(backtest) {
-            return backtest.configuration;
-        });
+        if (!backtests || !backtests.length) {
+            callback(configurationSpace.getCount() ? [[0, configurationSpace.getCount()]] : []);
+            return;
+        }
 
-        // Iterate of configurations, and remove ones already used in completed backtests.
-        completedConfigurations.forEach(function(completedConfiguration) {
-            var foundIndex = -1;
+        // Find the indexes of completed configurations from the configurations themselves, so resuming takes
+        // time in proportion to the backtests done rather than the size of the space. Configurations not in
+        // the space (such as from a run with other options) match none of its configurations and are ignored.
+        backtests.forEach(function(backtest) {
+            var index = -1;
 
-            _.find(configurations, function(configuration, index) {
-                var found = _.isEqual(configuration, completedConfiguration);
-                if (found) {
-                    foundIndex = index;
-                }
-                return found;
-            });
+            if (backtest.configuration) {
+                index = configurationSpace.indexOf(backtest.configuration);
 
-            if (foundIndex > -1) {
-                // The configuration was already backtested, so remove it from the list
-                // of configurations to backtest.
-                configurations.splice(foundIndex, 1);
+                if (index > -1) {
+                    completedIndexes.push(index);
+                }
+            }
+            else if (backtest.configurationHash) {
+                completedHashes = completedHashes || {};
+                completedHashes[backtest.configurationHash] = true;
             }
         });
 
-        callback();
-    });
+        // Backtests saved with only a configuration hash can only be matched by hashing every configuration.
+        if (completedHashes) {
+            configurationSpace.forEachInRanges(configurationSpace.getRangesExcluding(completedIndexes), function(configuration, index) {
+                if (completedHashes[Checkpoint.getConfigurationHash(configuration)]) {
+                    completedIndexes.push(index);
+                }
+            });
+        }
+
+        callback(configurationSpace.getRangesExcluding(completedIndexes));
+    }));
+};
+
+// Checkpoints for each window are kept apart, since strategies continued from them must have been
+// backtested over the same data.
+Base.prototype.getCheckpoint = function() {
+    var name = this.strategyName;
+
+    if (this.window) {
+        name += '_' + this.window.inSampleStart + '_' + this.window.inSampleEnd;
+    }
+
+    return new Checkpoint(path.join(this.store.getDirectory(), 'checkpoints', name));
+};
+
+// Takes the next chunk of configuration index ranges off the front of a list of ranges. Chunks shrink as
+// fewer configurations remain (guided scheduling), so that forks finish at about the same time even
+// though configurations differ widely in cost.
+Base.prototype.takeConfigurationChunk = function(configurationRanges, forkCount) {
+    var remainingCount = ConfigurationSpace.countRanges(configurationRanges);
+    var chunkSize = Math.max(Math.ceil(remainingCount / (forkCount * chunksPerFork)), minimumChunkSize);
+    var chunk = [];
+    var range = null;
+    var end = 0;
+
+    while (chunkSize > 0 && configurationRanges.length) {
+        range = configurationRanges[0];
+        end = Math.min(range[1], range[0] + chunkSize);
+
+        chunk.push([range[0], end]);
+        chunkSize -= end - range[0];
+
+        if (end === range[1]) {
+            configurationRanges.shift();
+        }
+        else {
+            range[0] = end;
+        }
+    }
+
+    return chunk;
 };
 
-Base.prototype.optimize = function(configurations, investment, profitability, callback) {
+Base.prototype.optimize = function(configurationSpace, investment, profitability, callback) {
     var self = this;
-    var strategies = [];
-    var dataPointCount = 0;
     var tasks = [];
     var forks = [];
-    var cpuCoreCount = 1;  //require('os').cpus().length;
+    var workerStatistics = {};
+    var configurationRanges = [];
+    var configurationCount = 0;
+    var completedCount = 0;
+    var cpuCoreCount = require('os').cpus().length;
+    var checkpoint = self.getCheckpoint();
+    var runName = String(Date.now());
+    var settings = {};
+    var showProgress = progress.create(13);
+    var stopTimer = metrics.time('optimize');
+    var backtestWriter = new WriteBuffer(Backtest.collection, {
+        metricName: 'mongo.insert.backtests',
+        writeConcern: self.writeConcern
+    });
 
     process.stdout.write('Optimizing...');
 
-    // Create child processes for parallel processing.
-    tasks.push(function(taskCallback) {
-        var index = 0;
+    // Records the results for a completed chunk of configurations.
+    function saveChunk(workerName, data, chunkCallback) {
+        var statistics = workerStatistics[workerName];
+
+        if (!statistics) {
+            statistics = workerStatistics[workerName] = {
+                chunkCount: 0,
+                configurationCount: 0,
+                dataPointCount: 0,
+                duration: 0
+            };
+        }
 
-        for (index = 0; index < cpuCoreCount; index++) {
-            forks.push(forkFn(__dirname + '/worker.js'));
+        statistics.chunkCount++;
+        statistics.configurationCount += data.configurationCount;
+        statistics.dataPointCount += data.dataPointCount;
+        statistics.duration += data.duration;
+
+        completedCount += data.configurationCount;
+
+        metrics.increment('configurations', data.configurationCount);
+        metrics.increment('dataPoints', data.dataPointCount);
+        metrics.setGauge('remainingConfigurations', configurationCount - completedCount);
+
+        if (data.metrics) {
+            metrics.setWorkerSnapshot(workerName, data.metrics);
         }
 
-        taskCallback();
-    });
+        showProgress(completedCount + ' of ' + configurationCount + ' configurations completed', completedCount === configurationCount);
+
+        // Results are saved before the worker is given another chunk, since the worker's checkpoint no longer
+        // covers them. Results from workers finishing at about the same time are inserted together.
+        backtestWriter.push(data.results);
+        backtestWriter.flush(chunkCallback);
+    }
 
     // Exclude configurations that have already been backtested.
     tasks.push(function(taskCallback) {
-        self.removeCompletedConfigurations(configurations, taskCallback);
+        self.findRemainingConfigurations(configurationSpace, function(ranges) {
+            configurationRanges = ranges;
+            configurationCount = ConfigurationSpace.countRanges(ranges);
+            taskCallback();
+        });
     });
 
-    // Get a count of all data points.
+    // Settings every worker is initialized with. Workers backtest the data points from dataStart up to
+    // dataPointCount.
     tasks.push(function(taskCallback) {
-        DataPoint.count({symbol: self.symbol}, function(error, count) {
-            dataPointCount = count;
-            taskCallback(error);
-        });
+        settings = {
+            runName: runName,
+            strategyName: self.strategyName,
+            symbol: self.symbol,
+            configurationOptions: configurationSpace.getOptions(),
+            dataStart: self.window ? self.window.start : 0,
+            dataPointCount: self.window ? self.window.end : self.store.getCount(),
+            window: self.window ? {inSampleStart: self.window.inSampleStart, inSampleEnd: self.window.inSampleEnd} : null,
+            storeDirectory: self.store.getDirectory(),
+            investment: investment,
+            profitability: profitability,
+            aggregateOnly: self.aggregateOnly,
+            positionConstraints: self.positionConstraints,
+            pruningConstraints: self.pruningConstraints,
+            writeConcern: self.writeConcern
+        };
+
+        taskCallback();
     });
 
-    // Assign configurations to forks.
+    // Let remote agents lease chunks of configurations, if coordinating.
     tasks.push(function(taskCallback) {
-        configurations.forEach(function(configuration, index) {
-            forks[index % cpuCoreCount].send({
-                type: 'init',
-                data: {
-                    strategyName: self.strategyName,
-                    symbol: self.symbol,
-                    configuration: configuration,
-                    dataPointCount: dataPointCount
-                }
-            });
-        });
+        if (!self.coordinator) {
+            taskCallback();
+            return;
+        }
 
-        taskCallback();
+        self.coordinator.run(settings, function(workerCount) {
+            return self.takeConfigurationChunk(configurationRanges, workerCount);
+        }, saveChunk, taskCallback);
     });
 
-    // Use a stream to interate over the data in batches so as to not consume too much memory.
+    // Otherwise create child processes for parallel processing.
     tasks.push(function(taskCallback) {
         var index = 0;
 
-        var streamer = function(dataPoint) {
-            stream.pause();
+        if (self.coordinator) {
+            taskCallback();
+            return;
+        }
 
-            var completionCount = 0;
+        if (self.sharedForks) {
+            forks = self.sharedForks;
+            cpuCoreCount = forks.length;
+            taskCallback();
+            return;
+        }
 
-            forks.forEach(function(fork) {
-                fork.send({
-                    type: 'backtest',
-                    data: {
-                        dataPoint: dataPoint.data,
-                        index: index,
-                        investment: investment,
-                        profitability: profitability
-                    }
-                });
+        // Do not create more child processes than there are configurations to backtest.
+        cpuCoreCount = Math.max(Math.min(cpuCoreCount, configurationCount), 1);
 
-                function handler(message) {
-                    if (message.type !== 'done') {
-                        return;
-                    }
+        for (index = 0; index < cpuCoreCount; index++) {
+            forks.push(forkFn(__dirname + '/worker.js'));
+        }
 
-                    fork.removeListener('message', handler);
+        taskCallback();
+    });
+
+    // Hand out chunks of configurations to forks as they become idle. Each fork decodes its configurations
+    // from the index ranges it is given, backtests them against the prepared data (continuing from any
+    // checkpoint left by an interrupted run), and sends back their results, which are saved before the
+    // fork is given its next chunk.
+    tasks.push(function(taskCallback) {
+        var idleCount = 0;
+        var busyCount = 0;
 
-                    if (++completionCount === cpuCoreCount) {
-                        index++;
+        if (!forks.length) {
+            taskCallback();
+            return;
+        }
 
-                        process.stdout.cursorTo(13);
-                        process.stdout.write(index + ' of ' + dataPointCount + ' completed');
+        forks.forEach(function(fork, forkIndex) {
+            var chunkStartTime = 0;
 
-                        if (index === dataPointCount) {
-                            strategyFns.optimization[self.strategyName].saveExpiredPositionsPool(function() {
-                                taskCallback();
-                            });
-                        }
+            function sendChunk() {
+                var chunk = self.takeConfigurationChunk(configurationRanges, cpuCoreCount);
+
+                if (!chunk.length) {
+                    // Nothing is left to do.
+                    fork.removeListener('message', handler);
 
-                        stream.resume();
+                    if (++idleCount === cpuCoreCount) {
+                        taskCallback();
                     }
+                    return;
                 }
 
-                fork.on('message', handler);
-            });
-        };
+                chunkStartTime = Date.now();
+                metrics.setGauge('busyForks', ++busyCount);
+
+                fork.send({type: 'chunk', data: {configurationRanges: chunk}});
+            }
+
+            function handler(message) {
+                var roundTripTime = 0;
+
+                if (message.type === 'chunkDone') {
+                    // Time a chunk spends outside of the fork's backtesting is mostly messaging.
+                    roundTripTime = Date.now() - chunkStartTime;
+                    metrics.recordLatency('chunkRoundTrip', roundTripTime);
+                    metrics.recordLatency('chunkMessaging', Math.max(roundTripTime - message.data.duration, 0));
+                    metrics.setGauge('busyForks', --busyCount);
+
+                    saveChunk('Fork ' + forkIndex, message.data, sendChunk);
+                }
+            }
 
-        var stream = DataPoint.find({symbol: self.symbol}, {}, {timeout: true}).hint({'data.timestamp': 1}).sort({'data.timestamp': 1}).stream();
+            fork.on('message', handler);
 
-        stream.on('data', streamer);
+            fork.send({
+                type: 'init',
+                data: _.extend({}, settings, {
+                    checkpointDirectory: checkpoint.getDirectory(),
+                    checkpointName: runName + '_' + forkIndex
+                })
+            });
+
+            sendChunk();
+        });
     });
 
-    // Record the results for each strategy.
+    // Report throughput for each fork or agent worker.
     tasks.push(function(taskCallback) {
-        process.stdout.cursorTo(13);
-        process.stdout.write(dataPointCount + ' of ' + dataPointCount + ' completed\n');
-        process.stdout.write('Saving results...');
-
-        var backtests = [];
-        var resultsCount = 0;
+        process.stdout.write('\n');
 
-        forks.forEach(function(fork) {
-            fork.send({type: 'results'});
+        Object.keys(workerStatistics).forEach(function(workerName) {
+            var statistics = workerStatistics[workerName];
+            var seconds = statistics.duration / 1000;
 
-            fork.on('message', function(message) {
-                if (message.type !== 'results') {
-                    return;
-                }
+            process.stdout.write(workerName + ': ' + statistics.configurationCount + ' configurations in ' + statistics.chunkCount + ' chunks, ' + Math.round(seconds) + 's busy, ' + (seconds ? Math.round(statistics.dataPointCount / seconds) : 0) + ' data points/s\n');
+        });
 
-                resultsCount++;
-                backtests = backtests.concat(message.data);
+        taskCallback();
+    });
 
-                if (resultsCount === cpuCoreCount) {
-                    Backtest.collection.insert(backtests, function(error) {
-                        process.stdout.write('done\n');
+    // Make sure all results are saved.
+    tasks.push(function(taskCallback) {
+        backtestWriter.flush(taskCallback);
+    });
 
-                        taskCallback(error);
-                    });
-                }
+    // The forks are no longer needed (unless shared), and the run is complete so checkpoints are no longer
+    // needed either.
+    tasks.push(function(taskCallback) {
+        if (!self.sharedForks) {
+            forks.forEach(function(fork) {
+                fork.kill();
             });
-        });
+        }
+
+        checkpoint.clear();
+        stopTimer();
+
+        taskCallback();
     });
 
     // Run tasks.
@@ -0,0 +1,354 @@
+var fs = require('fs');
+var http = require('http');
+var ColumnStore = require('../ColumnStore');
+var metrics = require('../metrics');
+
+// Number of milliseconds agents are told to wait before asking again when no chunk is available yet.
+var waitDelay = 5000;
+
+// Serves an optimization run to remote agents over HTTP. Agents download the prepared data, lease chunks of
+// configuration index ranges, run them through the same worker used by local forks, and post the results
+// back. A lease that is not renewed within the lease timeout (for example, because its agent died) is
+// handed out again.
+//
+// Requests and responses are JSON:
+//
+//     GET  /settings                   Settings to initialize workers with, and the store manifest.
+//     GET  /store/<column>             Raw column file from the prepared data store.
+//     GET  /metrics                    Metrics for the run (see metrics.js), including each worker's.
+//     POST /leases                     Leases the next chunk: {lease: {id, chunkIndex, configurationRanges}},
+//                                      {wait}, or {done}.
+//     POST /leases/<id>/renew          Extends a lease, or responds 410 if it has expired.
+//     POST /leases/<id>/results        Records the results for a leased chunk.
+function Coordinator(port, leaseTimeout) {
+    this.port = port;
+    this.leaseTimeout = leaseTimeout;
+    this.server = null;
+    this.store = null;
+    this.settings = null;
+    this.chunks = [];
+    this.leases = {};
+    this.expiredChunks = [];
+    this.workerTimes = {};
+    this.pendingChunk = null;
+    this.leaseCount = 0;
+    this.done = false;
+}
+
+// Runs the coordinator until every chunk has results. takeChunk(workerCount) returns the next chunk of
+// configuration ranges (empty once there are none left), and saveChunk(workerId, data, callback) records
+// the results for a chunk.
+Coordinator.prototype.run = function(settings, takeChunk, saveChunk, callback) {
+    var self = this;
+    var expirationInterval = null;
+
+    self.settings = settings;
+    self.store = new ColumnStore(settings.storeDirectory);
+    self.takeChunk = takeChunk;
+
+    // The last chunks can be saved at about the same time, so only the first to find the run complete
+    // finishes it.
+    function finish() {
+        if (self.done) {
+            return;
+        }
+
+        clearInterval(expirationInterval);
+        self.done = true;
+
+        // Let agents that are still polling find out that the run is over before shutting down.
+        setTimeout(function() {
+            self.server.close();
+            self.store.close();
+            callback();
+        }, waitDelay * 2);
+    }
+
+    self.saveChunk = function(workerId, data, chunkCallback) {
+        saveChunk(workerId, data, function() {
+            chunkCallback();
+
+            if (self.isComplete()) {
+                finish();
+            }
+        });
+    };
+
+    expirationInterval = setInterval(function() {
+        self.expireLeases();
+    }, Math.max(Math.floor(self.leaseTimeout / 4), 1000));
+
+    self.server = http.createServer(function(request, response) {
+        self.handleRequest(request, response);
+    });
+    self.server.listen(self.port, function() {
+        process.stdout.write('\nWaiting for agents on port ' + self.port + '...\n');
+    });
+
+    // Nothing may be left to do.
+    if (self.isComplete()) {
+        finish();
+    }
+};
+
+// Returns whether every chunk has results and there are no more to hand out.
+Coordinator.prototype.isComplete = function() {
+    if (this.expiredChunks.length || Object.keys(this.leases).length) {
+        return false;
+    }
+
+    // Peek at whether any configurations remain by taking a chunk, and keep it for the next lease.
+    if (!this.pendingChunk) {
+        this.pendingChunk = this.createChunk();
+    }
+
+    return !this.pendingChunk;
+};
+
+// Returns the number of workers that have asked for work recently.
+Coordinator.prototype.getWorkerCount = function() {
+    var self = this;
+    var now = Date.now();
+
+    return Math.max(Object.keys(self.workerTimes).filter(function(workerId) {
+        return now - self.workerTimes[workerId] < self.leaseTimeout;
+    }).length, 1);
+};
+
+Coordinator.prototype.createChunk = function() {
+    var configurationRanges = this.takeChunk(this.getWorkerCount());
+    var chunk = null;
+
+    if (!configurationRanges.length) {
+        return null;
+    }
+
+    chunk = {
+        index: this.chunks.length,
+        configurationRanges: configurationRanges,
+        complete: false
+    };
+    this.chunks.push(chunk);
+
+    return chunk;
+};
+
+// Returns the next chunk to lease, preferring chunks whose previous leases expired.
+Coordinator.prototype.getNextChunk = function() {
+    var chunk = null;
+
+    while (this.expiredChunks.length) {
+        chunk = this.expiredChunks.shift();
+
+        // Results may have arrived late from the original lease.
+        if (!chunk.complete) {
+            return chunk;
+        }
+    }
+
+    if (this.pendingChunk) {
+        chunk = this.pendingChunk;
+        this.pendingChunk = null;
+
+        return chunk;
+    }
+
+    return this.createChunk();
+};
+
+Coordinator.prototype.createLease = function(workerId) {
+    var chunk = this.getNextChunk();
+    var lease = null;
+
+    if (!chunk) {
+        return null;
+    }
+
+    lease = {
+        id: String(++this.leaseCount),
+        chunk: chunk,
+        workerId: workerId,
+        expirationTime: Date.now() + this.leaseTimeout
+    };
+    this.leases[lease.id] = lease;
+
+    return lease;
+};
+
+// Puts the chunks for leases that have not been renewed in time back in line to be leased again.
+Coordinator.prototype.expireLeases = function() {
+    var now = Date.now();
+    var leaseId = '';
+    var lease = null;
+
+    for (leaseId in this.leases) {
+        lease = this.leases[leaseId];
+
+        if (lease.expirationTime < now) {
+            process.stdout.write('\nLease ' + leaseId + ' for ' + lease.workerId + ' expired; dispatching its configurations again\n');
+
+            delete this.leases[leaseId];
+            this.expiredChunks.push(lease.chunk);
+        }
+    }
+};
+
+Coordinator.prototype.handleRequest = function(request, response) {
+    var self = this;
+    var body = '';
+
+    request.setEncoding('utf8');
+    request.on('data', function(data) {
+        body += data;
+    });
+    request.on('end', function() {
+        var parts = request.url.split('/').slice(1);
+        var data = null;
+
+        try {
+            data = body ? JSON.parse(body) : {};
+        }
+        catch (error) {
+            self.respond(response, 400, {error: 'Invalid JSON'});
+            return;
+        }
+
+        if (request.method === 'GET' && parts[0] === 'settings') {
+            self.respond(response, 200, {
+                settings: self.settings,
+                manifest: self.store.load(),
+                leaseTimeout: self.leaseTimeout
+            });
+        }
+        else if (request.method === 'GET' && parts[0] === 'store' && parts.length === 2) {
+            self.sendColumn(response, decodeURIComponent(parts[1]));
+        }
+        else if (request.method === 'GET' && parts[0] === 'metrics') {
+            self.respond(response, 200, self.getMetrics());
+        }
+        else if (request.method === 'POST' && parts[0] === 'leases' && parts.length === 1) {
+            self.handleLease(response, data);
+        }
+        else if (request.method === 'POST' && parts[0] === 'leases' && parts[2] === 'renew') {
+            self.handleRenewal(response, parts[1]);
+        }
+        else if (request.method === 'POST' && parts[0] === 'leases' && parts[2] === 'results') {
+            self.handleResults(response, parts[1], data);
+        }
+        else {
+            self.respond(response, 404, {error: 'Not found'});
+        }
+    });
+};
+
+Coordinator.prototype.getMetrics = function() {
+    metrics.setGauge('activeLeases', Object.keys(this.leases).length);
+    metrics.setGauge('expiredChunks', this.expiredChunks.length);
+    metrics.setGauge('workers', this.getWorkerCount());
+
+    return metrics.snapshot();
+};
+
+Coordinator.prototype.respond = function(response, statusCode, data) {
+    var body = JSON.stringify(data);
+
+    response.writeHead(statusCode, {
+        'Content-Type': 'application/json',
+        'Content-Length': Buffer.byteLength(body)
+    });
+    response.end(body);
+};
+
+Coordinator.prototype.sendColumn = function(response, columnName) {
+    // Only serve files for columns in the store.
+    if (!this.store.hasColumn(columnName)) {
+        this.respond(response, 404, {error: 'Unknown column'});
+        return;
+    }
+
+    response.writeHead(200, {
+        'Content-Type': 'application/octet-stream',
+        'Content-Length': fs.statSync(this.store.getColumnPath(columnName)).size
+    });
+    fs.createReadStream(this.store.getColumnPath(columnName)).pipe(response);
+};
+
+Coordinator.prototype.handleLease = function(response, data) {
+    var lease = null;
+
+    if (!data.workerId) {
+        this.respond(response, 400, {error: 'No worker ID provided'});
+        return;
+    }
+
+    this.workerTimes[data.workerId] = Date.now();
+
+    if (this.done) {
+        this.respond(response, 200, {done: true});
+        return;
+    }
+
+    lease = this.createLease(data.workerId);
+
+    if (!lease) {
+        // Other agents are still working on the last chunks, and one of their leases may yet expire.
+        this.respond(response, 200, {wait: waitDelay});
+        return;
+    }
+
+    this.respond(response, 200, {
+        lease: {
+            id: lease.id,
+            chunkIndex: lease.chunk.index,
+            configurationRanges: lease.chunk.configurationRanges
+        }
+    });
+};
+
+Coordinator.prototype.handleRenewal = function(response, leaseId) {
+    var lease = this.leases[leaseId];
+
+    if (!lease) {
+        this.respond(response, 410, {error: 'Lease expired'});
+        return;
+    }
+
+    lease.expirationTime = Date.now() + this.leaseTimeout;
+    this.workerTimes[lease.workerId] = Date.now();
+
+    this.respond(response, 200, {});
+};
+
+Coordinator.prototype.handleResults = function(response, leaseId, data) {
+    var self = this;
+    var lease = self.leases[leaseId];
+    var chunkIndex = parseInt(data.chunkIndex);
+    var chunk = lease ? lease.chunk : self.chunks[chunkIndex];
+
+    if (!chunk || !data.results) {
+        self.respond(response, 400, {error: 'Unknown lease'});
+        return;
+    }
+
+    // Results from an expired lease are still used if the chunk has not been completed by another lease
+    // since, but otherwise they are duplicates.
+    if (chunk.complete) {
+        self.respond(response, 200, {duplicate: true});
+        return;
+    }
+
+    chunk.complete = true;
+
+    // Any other lease for the chunk is no longer needed.
+    for (leaseId in self.leases) {
+        if (self.leases[leaseId].chunk === chunk) {
+            delete self.leases[leaseId];
+        }
+    }
+
+    self.saveChunk(data.workerId || (lease && lease.workerId), data, function() {
+        self.respond(response, 200, {});
+    });
+};
+
+module.exports = Coordinator;
@@ -424,22 +424,25 @@ function Reversals(symbol) {
     // Prepare studies for use.
     this.prepareStudies(studyDefinitions);
 
-    // Prepare all optimization configurations.
-    this.configurations = this.buildConfigurations(configurationOptions);
+    // Prepare the space of all optimization configurations (built on demand).
+    this.configurationSpace = this.buildConfigurationSpace(configurationOptions);
 }
 
 // Create a copy of the Base "class" prototype for use in this "class."
 Reversals.prototype = Object.create(Base.prototype);
 
-Reversals.prototype.optimize = function(data, investment, profitability, done) {
+Reversals.prototype.optimize = function(dataParser, dataFilePath, investment, profitability, done) {
     var self = this;
 
     // Prepare all data in advance for use.
-    self.prepareStudyData(data, function() {
-        // Ensure memory is released.
-        data = null;
+    self.prepareStudyData(dataParser, dataFilePath, function(error) {
+        // Optimizing over partially prepared data would give wrong results.
+        if (error) {
+            console.error(error.message || error);
+            process.exit(1);
+        }
 
-        Base.prototype.optimize.call(self, self.configurations, investment, profitability, done);
+        Base.prototype.optimize.call(self, self.configurationSpace, investment, profitability, done);
     });
 };
 
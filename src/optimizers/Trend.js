@@ -33,22 +33,25 @@ function Trend(symbol) {
     // Prepare studies for use.
     this.prepareStudies(studyDefinitions);
 
-    // Prepare all optimization configurations.
-    this.configurations = this.buildConfigurations(configurationOptions);
+    // Prepare the space of all optimization configurations (built on demand).
+    this.configurationSpace = this.buildConfigurationSpace(configurationOptions);
 }
 
 // Create a copy of the Base "class" prototype for use in this "class."
 Trend.prototype = Object.create(Base.prototype);
 
-Trend.prototype.optimize = function(data, investment, profitability, done) {
+Trend.prototype.optimize = function(dataParser, dataFilePath, investment, profitability, done) {
     var self = this;
 
     // Prepare all data in advance for use.
-    self.prepareStudyData(data, function() {
-        // Ensure memory is released.
-        data = null;
-
-        Base.prototype.optimize.call(self, self.configurations, investment, profitability, done);
+    self.prepareStudyData(dataParser, dataFilePath, function(error) {
+        // Optimizing over partially prepared data would give wrong results.
+        if (error) {
+            console.error(error.message || error);
+            process.exit(1);
+        }
+
+        Base.prototype.optimize.call(self, self.configurationSpace, investment, profitability, done);
     });
 };
 
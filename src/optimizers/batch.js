@@ -0,0 +1,135 @@
+var async = require('async');
+var forkFn = require('child_process').fork;
+var optimizers = require('./index');
+var dataParsers = require('../dataParsers');
+
+// Prepares study data for a job in a separate process, calling back once the data is cached.
+function prepare(optimizerName, parserName, job, callback) {
+    var preparer = forkFn(__dirname + '/preparer.js');
+    var finished = false;
+
+    function finish(error) {
+        if (finished) {
+            return;
+        }
+
+        finished = true;
+        callback(error);
+    }
+
+    preparer.on('message', function(message) {
+        if (message.type !== 'prepared') {
+            return;
+        }
+
+        preparer.kill();
+        finish(message.data.error);
+    });
+
+    // The preparer may die without replying, such as on an error thrown asynchronously.
+    preparer.on('exit', function(code, signal) {
+        finish('Study data preparation for ' + job.symbol + ' exited with ' + (signal || 'code ' + code));
+    });
+
+    preparer.on('error', function(error) {
+        finish(String(error.message || error));
+    });
+
+    preparer.send({
+        type: 'prepare',
+        data: {
+            optimizerName: optimizerName,
+            parserName: parserName,
+            symbol: job.symbol,
+            dataFilePath: job.dataFilePath
+        }
+    });
+}
+
+// Optimizes a batch of jobs (each a symbol and data file) using one set of worker forks. Study data for
+// the next job is prepared while the current one is optimized, and only one job is prepared ahead, so
+// at most two jobs' data are being worked on at once. configure(optimizer) is called for each job's
+// optimizer before it runs.
+module.exports.run = function(optimizerName, parserName, jobs, investment, profitability, configure, callback) {
+    var cpuCoreCount = require('os').cpus().length;
+    var forks = [];
+    var preparations = [];
+    var tasks = [];
+    var index = 0;
+
+    for (index = 0; index < cpuCoreCount; index++) {
+        forks.push(forkFn(__dirname + '/worker.js'));
+    }
+
+    // Starts preparing study data for a job, if it has not been started already.
+    function startPreparation(jobIndex) {
+        if (jobIndex >= jobs.length || preparations[jobIndex]) {
+            return;
+        }
+
+        preparations[jobIndex] = {
+            done: false,
+            error: null,
+            callbacks: []
+        };
+
+        prepare(optimizerName, parserName, jobs[jobIndex], function(error) {
+            var preparation = preparations[jobIndex];
+
+            preparation.done = true;
+            preparation.error = error;
+            preparation.callbacks.forEach(function(preparationCallback) {
+                preparationCallback(error);
+            });
+        });
+    }
+
+    function waitForPreparation(jobIndex, preparationCallback) {
+        var preparation = preparations[jobIndex];
+
+        if (preparation.done) {
+            preparationCallback(preparation.error);
+            return;
+        }
+
+        preparation.callbacks.push(preparationCallback);
+    }
+
+    jobs.forEach(function(job, jobIndex) {
+        tasks.push(function(taskCallback) {
+            startPreparation(jobIndex);
+
+            waitForPreparation(jobIndex, function(error) {
+                var optimizer = null;
+
+                // Prepare the next job's data while this one is optimized.
+                startPreparation(jobIndex + 1);
+
+                if (error) {
+                    console.error('Could not prepare data for ' + job.symbol + ': ' + error);
+                    taskCallback();
+                    return;
+                }
+
+                process.stdout.write('Optimizing ' + job.symbol + ' (' + (jobIndex + 1) + ' of ' + jobs.length + ')\n');
+
+                optimizer = new optimizers[optimizerName](job.symbol);
+                optimizer.setForks(forks);
+                configure(optimizer);
+
+                // The data is already cached, so this only loads it.
+                optimizer.optimize(dataParsers[parserName], job.dataFilePath, investment, profitability, function() {
+                    taskCallback();
+                });
+            });
+        });
+    });
+
+    async.series(tasks, function(error) {
+        forks.forEach(function(fork) {
+            fork.kill();
+        });
+
+        callback(error);
+    });
+};
@@ -0,0 +1,34 @@
+var optimizers = require('./index');
+var dataParsers = require('../dataParsers');
+
+// Prepares study data for a symbol in its own process, so that a batch run can parse and prepare one
+// symbol's data while the worker forks optimize another.
+process.on('message', function(message) {
+    var data = message.data;
+    var optimizer = null;
+
+    if (message.type !== 'prepare') {
+        return;
+    }
+
+    function reply(error) {
+        process.send({
+            type: 'prepared',
+            data: {
+                symbol: data.symbol,
+                error: error ? String(error.message || error) : null
+            }
+        });
+    }
+
+    // Errors such as a missing data file or one a parser cannot parse are thrown, and are reported back
+    // rather than leaving the batch run waiting.
+    try {
+        optimizer = new optimizers[data.optimizerName](data.symbol);
+
+        optimizer.getStudyCache(data.dataFilePath).prepare(optimizer.studyDefinitions, dataParsers[data.parserName], function() {}, reply);
+    }
+    catch (error) {
+        reply(error);
+    }
+});
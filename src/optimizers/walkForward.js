@@ -0,0 +1,236 @@
+var _ = require('lodash');
+var async = require('async');
+var forkFn = require('child_process').fork;
+var Base = require('./Base');
+var optimizers = require('./index');
+var dataParsers = require('../dataParsers');
+var Backtest = require('../models/Backtest');
+var Validation = require('../models/Validation');
+var strategyFns = require('../strategies');
+var constraints = require('../constraints');
+var metrics = require('../metrics');
+
+var dayLength = 24 * 60 * 60 * 1000;
+
+// Returns the index of the first timestamp at or after time, or the number of timestamps if there is none.
+function findIndex(timestamps, time) {
+    var low = 0;
+    var high = timestamps.length;
+    var middle = 0;
+
+    while (low < high) {
+        middle = (low + high) >>> 1;
+
+        if (timestamps[middle] < time) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+function formatDate(timestamp) {
+    return new Date(timestamp).toISOString().slice(0, 10);
+}
+
+// Returns rolling windows over prepared data, given its timestamps. Each window has an in-sample period of
+// options.inSample days followed by an out-of-sample period of options.outOfSample days, and windows start
+// every options.step days from the first timestamp. Periods are kept as timestamps (which identify a
+// window's backtests and validations, so an interrupted run can pick up where it left off) along with the
+// index range of the in-sample data points (start up to end) and the number of out-of-sample data points
+// following them. The last window's out-of-sample period may be cut short by the end of the data.
+module.exports.getWindows = function(timestamps, options) {
+    var windows = [];
+    var count = timestamps.length;
+    var inSampleLength = options.inSample * dayLength;
+    var outOfSampleLength = options.outOfSample * dayLength;
+    var stepLength = options.step * dayLength;
+    var startTime = 0;
+    var window = null;
+
+    if (!count) {
+        return windows;
+    }
+
+    for (startTime = timestamps[0]; startTime + inSampleLength <= timestamps[count - 1]; startTime += stepLength) {
+        window = {
+            inSampleStart: startTime,
+            inSampleEnd: startTime + inSampleLength,
+            outOfSampleStart: startTime + inSampleLength,
+            outOfSampleEnd: startTime + inSampleLength + outOfSampleLength
+        };
+
+        window.start = findIndex(timestamps, window.inSampleStart);
+        window.end = findIndex(timestamps, window.inSampleEnd);
+        window.outOfSampleCount = findIndex(timestamps, window.outOfSampleEnd) - window.end;
+
+        // Skip windows with no data on one side, such as over long gaps in the data.
+        if (window.start < window.end && window.outOfSampleCount > 0) {
+            windows.push(window);
+        }
+    }
+
+    return windows;
+};
+
+// Forward tests the backtests over a window's in-sample period that satisfy the constraints, in a single pass
+// over the window's out-of-sample data, and saves the results as validations.
+function forwardTest(symbol, strategyFn, store, window, selectionConstraints, investment, profitability, callback) {
+    var periods = {
+        inSampleStart: window.inSampleStart,
+        inSampleEnd: window.inSampleEnd,
+        outOfSampleStart: window.outOfSampleStart,
+        outOfSampleEnd: window.outOfSampleEnd
+    };
+    var backtestQuery = _.extend({}, selectionConstraints, {
+        symbol: symbol,
+        inSampleStart: window.inSampleStart,
+        inSampleEnd: window.inSampleEnd,
+        pruned: {'$ne': true}
+    });
+
+    Validation.find(_.extend({symbol: symbol}, periods), {_id: 1}, metrics.timeCallback('mongo.find.validations', function(error, validations) {
+        if (error) {
+            console.error(error.message || error);
+        }
+
+        // The window was forward tested by an earlier run.
+        if (validations && validations.length) {
+            callback();
+            return;
+        }
+
+        Backtest.find(backtestQuery, metrics.timeCallback('mongo.find.backtests', function(error, backtests) {
+            var strategies = [];
+            var dataPoints = null;
+            var results = [];
+            var stopTimer = null;
+
+            if (error) {
+                console.error(error.message || error);
+            }
+
+            backtests = backtests || [];
+
+            process.stdout.write('Forward testing ' + backtests.length + ' backtests...');
+
+            if (!backtests.length) {
+                process.stdout.write('done\n');
+                callback();
+                return;
+            }
+
+            // Set up a strategy instance for each backtest.
+            strategies = backtests.map(function(backtest) {
+                var strategy = new strategyFn(symbol, [backtest.configuration]);
+
+                strategy.setProfitLoss(10000);
+
+                return strategy;
+            });
+
+            stopTimer = metrics.time('readDataPoints');
+            dataPoints = store.readDataPoints(window.end, window.outOfSampleCount);
+            stopTimer();
+
+            // Backtest (forward test) every strategy in a single pass over the out-of-sample data.
+            stopTimer = metrics.time('forwardtest');
+            results = strategyFn.backtestAll(strategies, dataPoints, investment, profitability).map(function(strategyResults, index) {
+                return _.extend(strategyResults, {
+                    symbol: symbol,
+                    strategyUuid: backtests[index].strategyUuid,
+                    configuration: backtests[index].configuration
+                }, periods);
+            });
+            stopTimer();
+
+            metrics.increment('dataPoints', strategies.length * dataPoints.length);
+
+            process.stdout.write('done\n');
+
+            Validation.collection.insert(results, metrics.timeCallback('mongo.insert.validations', function(error) {
+                if (error) {
+                    console.error(error.message || error);
+                }
+
+                callback();
+            }));
+        }));
+    }));
+}
+
+// Walk-forward tests an optimizer's strategy over one data file. Study data is prepared once, then for each
+// window (see getWindows()) the configuration space is optimized over the in-sample data and the backtests
+// satisfying options.constraints are forward tested over the out-of-sample data with the strategy's combined
+// form. Every window reads the same prepared columns, and one set of worker forks is used for all of them.
+// configure(optimizer) is called before the run.
+module.exports.run = function(optimizerName, parserName, symbol, dataFilePath, options, investment, profitability, configure, callback) {
+    var optimizer = new optimizers[optimizerName](symbol);
+    var strategyFn = strategyFns.combined[optimizerName];
+    var selectionConstraints = options.constraints || constraints.defaults;
+    var cpuCoreCount = require('os').cpus().length;
+    var forks = [];
+    var windows = [];
+    var tasks = [];
+
+    if (!strategyFn) {
+        throw 'No combined strategy to forward test ' + optimizerName + ' backtests with.';
+    }
+
+    // Only results are needed to choose what to forward test, so positions are not saved, and backtests
+    // that cannot be chosen are stopped as soon as that is certain.
+    optimizer.setAggregateOnly(null);
+    optimizer.setPruning(selectionConstraints);
+    configure(optimizer);
+
+    tasks.push(function(taskCallback) {
+        optimizer.prepareStudyData(dataParsers[parserName], dataFilePath, taskCallback);
+    });
+
+    tasks.push(function(taskCallback) {
+        var store = optimizer.store;
+        var index = 0;
+
+        windows = module.exports.getWindows(store.readColumn('timestamp', 0, store.getCount()), options);
+
+        process.stdout.write('Walk-forward testing over ' + windows.length + ' windows\n');
+
+        for (index = 0; index < cpuCoreCount; index++) {
+            forks.push(forkFn(__dirname + '/worker.js'));
+        }
+
+        optimizer.setForks(forks);
+
+        taskCallback();
+    });
+
+    tasks.push(function(taskCallback) {
+        async.series(windows.map(function(window, windowIndex) {
+            return function(windowCallback) {
+                process.stdout.write('Window ' + (windowIndex + 1) + ' of ' + windows.length + ': in-sample ' + formatDate(window.inSampleStart) + ' to ' + formatDate(window.inSampleEnd) + ', out-of-sample to ' + formatDate(window.outOfSampleEnd) + '\n');
+
+                optimizer.setWindow(window);
+
+                // The data is already prepared, so the configuration space is optimized directly.
+                Base.prototype.optimize.call(optimizer, optimizer.configurationSpace, investment, profitability, function() {
+                    forwardTest(symbol, strategyFn, optimizer.store, window, selectionConstraints, investment, profitability, windowCallback);
+                });
+            };
+        }), taskCallback);
+    });
+
+    async.series(tasks, function(error) {
+        forks.forEach(function(fork) {
+            fork.kill();
+        });
+
+        if (optimizer.store) {
+            optimizer.store.close();
+        }
+
+        callback(error);
+    });
+};
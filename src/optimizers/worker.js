@@ -1,48 +1,273 @@
 var db = require('../../db');
-var async = require('async');
 var strategyFns = require('../strategies');
+var ColumnStore = require('../ColumnStore');
+var SignalMatrix = require('../SignalMatrix');
+var Checkpoint = require('../Checkpoint');
+var ConfigurationSpace = require('../ConfigurationSpace');
+var constraints = require('../constraints');
+var metrics = require('../metrics');
+var settings = null;
+var configurationSpace = null;
 var strategyFn = null;
 var strategies = [];
+var nextIndexes = [];
+var store = null;
+var columnNames = null;
+var checkpoint = null;
+var checkpointEntries = {};
+var checkpointPending = false;
+var pruningRules = null;
+var connected = false;
 
-db.initialize('forex-backtesting');
+// Sets up the fork for a run. Configurations are then sent in chunks. Forks shared by a batch of runs are
+// set up again for each run.
+function init(data) {
+    settings = data;
 
-function init(strategyName, symbol, configuration, dataPointCount) {
-    if (!strategyFn) {
-        strategyFn = strategyFns.optimization[strategyName];
+    // Workers run by remote agents save positions to the coordinator's database.
+    if (!connected) {
+        db.initialize('forex-backtesting', data.databaseHost);
+        connected = true;
     }
 
-    strategies.push(new strategyFns.optimization[strategyName](symbol, configuration, dataPointCount));
-};
+    configurationSpace = new ConfigurationSpace(data.configurationOptions);
+    strategyFn = strategyFns.optimization[data.strategyName];
+    strategyFn.configurePositionWrites({writeConcern: data.writeConcern});
+    pruningRules = data.pruningConstraints ? constraints.getPruningRules(data.pruningConstraints) : null;
 
-function backtest(dataPoint, index, investment, profitability) {
-    var tasks = [];
+    checkpoint = null;
+    checkpointEntries = {};
+
+    if (data.checkpointDirectory) {
+        checkpoint = new Checkpoint(data.checkpointDirectory);
+        checkpointEntries = checkpoint.load();
+    }
+}
+
+// Returns the names of all columns needed by the strategies.
+function getColumnNames() {
+    if (columnNames) {
+        return columnNames;
+    }
+
+    columnNames = [];
 
     strategies.forEach(function(strategy) {
-        tasks.push(function(taskCallback) {
-            strategy.backtest(dataPoint, index, investment, profitability, function() {
-                taskCallback();
-            });
+        strategy.getColumnNames().forEach(function(columnName) {
+            if (columnNames.indexOf(columnName) === -1) {
+                columnNames.push(columnName);
+            }
         });
     });
 
-    async.parallel(tasks, function() {
-        strategyFn.saveExpiredPositionsPool(function() {
-            process.send({type: 'done'});
-        });
+    return columnNames;
+}
+
+function getStore(block) {
+    if (!store || store.getDirectory() !== block.storeDirectory) {
+        store = new ColumnStore(block.storeDirectory);
+    }
+
+    return store;
+}
+
+// Backtests strategies against the block as a whole using a signal matrix shared by all strategies.
+function backtestBlock(block, blockStrategies) {
+    var columns = null;
+    var matrix = null;
+    var stopTimer = metrics.time('readBlock');
+
+    if (block.dataPoints) {
+        columns = SignalMatrix.buildColumns(block.dataPoints, getColumnNames());
+        matrix = new SignalMatrix(columns, block.dataPoints.length);
+    }
+    else {
+        columns = getStore(block).readColumns(getColumnNames(), block.start, block.count);
+        matrix = new SignalMatrix(columns, columns.timestamp.length);
+    }
+
+    stopTimer();
+    stopTimer = metrics.time('backtest');
+
+    blockStrategies.forEach(function(strategy) {
+        strategy.backtestBlock(matrix, block.investment, block.profitability);
     });
-};
 
-function getResults() {
-    var allResults = [];
+    stopTimer();
+
+    return block.start + matrix.getCount();
+}
+
+function backtestDataPoints(block, blockStrategies) {
+    var dataPoints = block.dataPoints;
+    var index = block.start;
+    var dataPointCount = 0;
+    var strategyCount = blockStrategies.length;
+    var stopTimer = metrics.time('readBlock');
+    var i = 0;
+    var j = 0;
+
+    // Blocks either include the data points themselves or refer to a range of the prepared data store.
+    if (!dataPoints) {
+        dataPoints = getStore(block).readDataPoints(block.start, block.count);
+    }
+
+    dataPointCount = dataPoints.length;
+
+    stopTimer();
+    stopTimer = metrics.time('backtest');
+
+    // Backtest every strategy against every data point in the block.
+    for (i = 0; i < dataPointCount; i++) {
+        for (j = 0; j < strategyCount; j++) {
+            // Strategies pruned part way through the block go no further.
+            if (!blockStrategies[j].pruned) {
+                blockStrategies[j].backtest(dataPoints[i], index, block.investment, block.profitability, function() {});
+            }
+        }
+
+        dataPoints[i] = null;
+        index++;
+    }
+
+    stopTimer();
+
+    return index;
+}
+
+// Backtests strategies against a block, returning the index following the block.
+function backtestStrategies(block, blockStrategies) {
+    if (strategyFn && strategyFn.prototype.backtestBlock) {
+        return backtestBlock(block, blockStrategies);
+    }
+
+    return backtestDataPoints(block, blockStrategies);
+}
+
+// Returns checkpoint entries with the current state of every strategy.
+function getCheckpointEntries() {
+    var entries = {};
+
+    strategies.forEach(function(strategy, index) {
+        entries[strategy.getConfigurationHash()] = {
+            index: nextIndexes[index],
+            state: strategy.getState()
+        };
+    });
+
+    return entries;
+}
+
+// Saves the state of every strategy, once the positions they have closed so far are in the database.
+// Positions are inserted in the background, so the state is taken now and written when they are. Blocks
+// backtested meanwhile are left for the next checkpoint.
+function writeCheckpoint() {
+    var entries = {};
+    var stopTimer = null;
+
+    if (!checkpoint || checkpointPending) {
+        return;
+    }
+
+    stopTimer = metrics.time('writeCheckpoint');
+    entries = getCheckpointEntries();
+    stopTimer();
+    checkpointPending = true;
+
+    strategyFn.whenPositionsSaved(function() {
+        stopTimer = metrics.time('writeCheckpoint');
+        checkpoint.write(settings.checkpointName, entries);
+        stopTimer();
+
+        checkpointPending = false;
+    });
+}
+
+function createBlock(start) {
+    return {
+        storeDirectory: settings.storeDirectory,
+        start: start,
+        count: Math.min(ColumnStore.chunkSize, settings.dataPointCount - start),
+        investment: settings.investment,
+        profitability: settings.profitability
+    };
+}
+
+// Backtests the strategies against the block, returning the number of data points backtested for all
+// strategies combined.
+function backtest(block) {
+    var blockStrategies = [];
+    var index = block.start + block.count;
+
+    // Strategies restored from a checkpoint skip blocks they have already been backtested against, and
+    // pruned strategies are not backtested any further.
+    strategies.forEach(function(strategy, strategyIndex) {
+        if (nextIndexes[strategyIndex] <= block.start && !strategy.isPruned()) {
+            blockStrategies.push(strategy);
+            nextIndexes[strategyIndex] = index;
+        }
+    });
+
+    if (blockStrategies.length) {
+        backtestStrategies(block, blockStrategies);
+    }
+
+    return blockStrategies.length * block.count;
+}
+
+// Backtests the given strategies again from the start, this time saving their positions. This is used
+// when only aggregate results were kept during the run.
+function replayPositions(replayStrategyUuids, callback) {
+    var replayStrategies = [];
+    var index = settings.dataStart;
 
     strategies.forEach(function(strategy) {
-        var results = strategy.getResults();
+        var replayStrategy = null;
+
+        if (replayStrategyUuids.indexOf(strategy.getUuid()) === -1) {
+            return;
+        }
 
-        allResults.push({
+        replayStrategy = new strategyFn(strategy.getSymbol(), strategy.getConfiguration(), settings.dataPointCount);
+        replayStrategy.setUuid(strategy.getUuid());
+        replayStrategy.setPruningRules(pruningRules);
+
+        replayStrategies.push(replayStrategy);
+    });
+
+    function next() {
+        var start = index;
+
+        // Strategies pruned during the run are pruned at the same point again.
+        replayStrategies = replayStrategies.filter(function(strategy) {
+            return !strategy.isPruned();
+        });
+
+        if (!replayStrategies.length || index >= settings.dataPointCount) {
+            callback();
+            return;
+        }
+
+        index = backtestStrategies(createBlock(index), replayStrategies);
+        metrics.increment('replayedDataPoints', replayStrategies.length * (index - start));
+
+        strategyFn.saveExpiredPositionsPool(function() {
+            setImmediate(next);
+        });
+    }
+
+    next();
+}
+
+function getResults() {
+    return strategies.map(function(strategy) {
+        var results = strategy.getResults();
+        var result = {
             symbol: strategy.getSymbol(),
             strategyUuid: strategy.getUuid(),
             strategyName: strategy.constructor.name,
             configuration: strategy.getConfiguration(),
+            configurationHash: strategy.getConfigurationHash(),
             profitLoss: results.profitLoss,
             winCount: results.winCount,
             loseCount: results.loseCount,
@@ -50,25 +275,137 @@ function getResults() {
             winRate: results.winRate,
             maximumConsecutiveLosses: results.maximumConsecutiveLosses,
             minimumProfitLoss: results.minimumProfitLoss
-        });
+        };
+
+        // Pruned backtests only cover the data up to where they were pruned.
+        if (strategy.isPruned()) {
+            result.pruned = true;
+        }
+
+        // Backtests over a window of the data record the window's in-sample period.
+        if (settings.window) {
+            result.inSampleStart = settings.window.inSampleStart;
+            result.inSampleEnd = settings.window.inSampleEnd;
+        }
+
+        return result;
+    });
+}
+
+// Backtests a chunk of configurations against the prepared data from settings.dataStart up to
+// settings.dataPointCount, then sends back their results.
+function backtestChunk(configurationRanges) {
+    var startTime = Date.now();
+    var dataPointCount = 0;
+    var index = 0;
+
+    strategies = [];
+    nextIndexes = [];
+    columnNames = null;
+
+    configurationSpace.forEachInRanges(configurationRanges, function(configuration) {
+        var strategy = new strategyFn(settings.symbol, configuration, settings.dataPointCount);
+        var entry = checkpointEntries[strategy.getConfigurationHash()];
+
+        strategy.setSavePositions(!settings.aggregateOnly);
+        strategy.setPruningRules(pruningRules);
+
+        // Continue from where a previous run left off, if possible.
+        if (entry) {
+            strategy.setState(entry.state);
+        }
+
+        strategies.push(strategy);
+        nextIndexes.push(entry ? entry.index : settings.dataStart);
     });
 
-    process.send({type: 'results', data: allResults});
-};
+    // Start from the earliest data point any of the strategies needs.
+    index = strategies.length ? Math.min.apply(Math, nextIndexes) : settings.dataPointCount;
 
+    // Record each strategy's UUID before any of its positions are saved. Positions saved before an
+    // interruption are then saved again under the same UUIDs when the run resumes, and so are rejected as
+    // duplicates (see Ledger.takeExpiredDocuments) rather than left behind. Checkpoints for the previous
+    // chunk have all been written by now, since they wait for positions the chunk saved before finishing.
+    if (checkpoint) {
+        checkpoint.write(settings.checkpointName, getCheckpointEntries());
+    }
+
+    function finish() {
+        var results = getResults();
+        var replayStrategyUuids = [];
+
+        // Save positions for configurations that satisfy the position constraints.
+        if (settings.aggregateOnly && settings.positionConstraints) {
+            replayStrategyUuids = results.filter(function(result) {
+                return constraints.matches(result, settings.positionConstraints);
+            }).map(function(result) {
+                return result.strategyUuid;
+            });
+        }
+
+        replayPositions(replayStrategyUuids, function() {
+            // Only send the results once all of the chunk's positions are saved.
+            strategyFn.flushPositions(function() {
+                if (store) {
+                    store.close();
+                    store = null;
+                }
+
+                metrics.increment('configurations', results.length);
+                metrics.increment('prunedConfigurations', results.filter(function(result) {
+                    return result.pruned;
+                }).length);
+                metrics.increment('dataPoints', dataPointCount);
+
+                // Start afresh for the next chunk.
+                strategies = [];
+                nextIndexes = [];
+                strategyFn.resetLedger();
+
+                process.send({
+                    type: 'chunkDone',
+                    data: {
+                        results: results,
+                        configurationCount: results.length,
+                        dataPointCount: dataPointCount,
+                        duration: Date.now() - startTime,
+                        metrics: metrics.snapshot()
+                    }
+                });
+            });
+        });
+    }
+
+    function next() {
+        var block = null;
+
+        if (index >= settings.dataPointCount) {
+            finish();
+            return;
+        }
+
+        block = createBlock(index);
+        dataPointCount += backtest(block);
+        index = block.start + block.count;
+
+        strategyFn.saveExpiredPositionsPool(function() {
+            writeCheckpoint();
+
+            setImmediate(next);
+        });
+    }
+
+    next();
+}
 
 process.on('message', function(message) {
     switch (message.type) {
         case 'init':
-            init(message.data.strategyName, message.data.symbol, message.data.configuration, message.data.dataPointCount);
-            break;
-
-        case 'backtest':
-            backtest(message.data.dataPoint, message.data.index, message.data.investment, message.data.profitability);
+            init(message.data);
             break;
 
-        case 'results':
-            getResults();
+        case 'chunk':
+            backtestChunk(message.data.configurationRanges);
             break;
     }
 });
@@ -0,0 +1,210 @@
+// Number of position records allocated for initially.
+var initialCapacity = 1024;
+
+var transactionTypes = ['CALL', 'PUT'];
+
+// Position records for many strategies, stored as parallel typed arrays rather than one object per
+// position. Records are referred to by index and reused once they have been saved, so backtesting
+// creates no garbage per position.
+function Ledger() {
+    this.capacity = 0;
+    this.strategySymbols = [];
+    this.strategyUuids = [];
+    this.freeRecords = new Int32Array(initialCapacity);
+    this.freeCount = 0;
+    this.expiredRecords = new Int32Array(initialCapacity);
+    this.expiredCount = 0;
+
+    this.grow(initialCapacity);
+}
+
+Ledger.CALL = 0;
+Ledger.PUT = 1;
+
+// Registers a strategy, returning the index to open its positions with.
+Ledger.prototype.registerStrategy = function(symbol, strategyUuid) {
+    this.strategySymbols.push(symbol);
+    this.strategyUuids.push(strategyUuid);
+
+    return this.strategyUuids.length - 1;
+};
+
+Ledger.prototype.setStrategyUuid = function(strategyIndex, strategyUuid) {
+    this.strategyUuids[strategyIndex] = strategyUuid;
+};
+
+Ledger.prototype.grow = function(capacity) {
+    var self = this;
+    var previousCapacity = self.capacity;
+    var freeRecords = new Int32Array(capacity);
+    var expiredRecords = new Int32Array(capacity);
+    var i = 0;
+
+    function resize(values, type) {
+        var resized = new type(capacity);
+
+        if (values) {
+            resized.set(values);
+        }
+
+        return resized;
+    }
+
+    self.types = resize(self.types, Uint8Array);
+    self.strategyIndexes = resize(self.strategyIndexes, Uint32Array);
+    self.timestamps = resize(self.timestamps, Float64Array);
+    self.prices = resize(self.prices, Float64Array);
+    self.investments = resize(self.investments, Float64Array);
+    self.profitabilities = resize(self.profitabilities, Float64Array);
+    self.expirationTimestamps = resize(self.expirationTimestamps, Float64Array);
+    self.closePrices = resize(self.closePrices, Float64Array);
+    self.closeTimestamps = resize(self.closeTimestamps, Float64Array);
+    self.profitLosses = resize(self.profitLosses, Float64Array);
+
+    expiredRecords.set(self.expiredRecords.subarray(0, self.expiredCount));
+    freeRecords.set(self.freeRecords.subarray(0, self.freeCount));
+
+    // The new records are all free.
+    for (i = capacity - 1; i >= previousCapacity; i--) {
+        freeRecords[self.freeCount++] = i;
+    }
+
+    self.freeRecords = freeRecords;
+    self.expiredRecords = expiredRecords;
+    self.capacity = capacity;
+};
+
+// Opens a position, returning its record.
+Ledger.prototype.open = function(type, strategyIndex, timestamp, price, investment, profitability, expirationMinutes) {
+    var record = 0;
+
+    if (!this.freeCount) {
+        this.grow(this.capacity * 2);
+    }
+
+    record = this.freeRecords[--this.freeCount];
+
+    this.types[record] = type;
+    this.strategyIndexes[record] = strategyIndex;
+    this.timestamps[record] = timestamp;
+    this.prices[record] = price;
+    this.investments[record] = investment;
+    this.profitabilities[record] = profitability;
+    this.closePrices[record] = 0.0;
+    this.closeTimestamps[record] = 0;
+    this.profitLosses[record] = 0.0;
+
+    // Calculate the expiration time.
+    this.expirationTimestamps[record] = timestamp + (expirationMinutes * 1000 * 60);
+
+    return record;
+};
+
+// Returns the details of an open position, for saving and later restoring it.
+Ledger.prototype.getPosition = function(record) {
+    return {
+        type: this.types[record],
+        timestamp: this.timestamps[record],
+        price: this.prices[record],
+        investment: this.investments[record],
+        profitability: this.profitabilities[record],
+        expirationTimestamp: this.expirationTimestamps[record]
+    };
+};
+
+// Opens a position from details returned by getPosition(), returning its record.
+Ledger.prototype.restore = function(position, strategyIndex) {
+    var record = this.open(position.type, strategyIndex, position.timestamp, position.price, position.investment, position.profitability, 0);
+
+    this.expirationTimestamps[record] = position.expirationTimestamp;
+
+    return record;
+};
+
+Ledger.prototype.getExpirationTimestamp = function(record) {
+    return this.expirationTimestamps[record];
+};
+
+Ledger.prototype.getInvestment = function(record) {
+    return this.investments[record];
+};
+
+// Closes a position, returning its profit/loss.
+Ledger.prototype.close = function(record, price, timestamp) {
+    var investment = this.investments[record];
+    var openPrice = this.prices[record];
+    var profitLoss = 0.0;
+
+    // Disregard transaction (set it to 0 profit/loss) if we don't have a good data point close to the expiry time available.
+    if (timestamp > this.expirationTimestamps[record]) {
+        profitLoss = investment;
+    }
+    // A win occurs if the closing price moved in the direction expected.
+    else if (this.types[record] === Ledger.CALL ? price > openPrice : price < openPrice) {
+        profitLoss = investment + (this.profitabilities[record] * investment);
+    }
+    // A draw occurs if the closing price is the same as the purchase price.
+    else if (price === openPrice) {
+        profitLoss = investment;
+    }
+
+    this.closePrices[record] = price;
+    this.closeTimestamps[record] = timestamp;
+    this.profitLosses[record] = profitLoss;
+
+    return profitLoss;
+};
+
+// Keeps a closed position until the next save.
+Ledger.prototype.expire = function(record) {
+    this.expiredRecords[this.expiredCount++] = record;
+};
+
+// Frees the record for a closed position without saving it.
+Ledger.prototype.release = function(record) {
+    this.freeRecords[this.freeCount++] = record;
+};
+
+Ledger.prototype.getExpiredCount = function() {
+    return this.expiredCount;
+};
+
+// Returns documents for all positions closed since the last call, and frees their records.
+//
+// Each document's _id is made from its strategy's UUID and when and how the position was opened, so a
+// position backtested again (for example when resuming from a checkpoint written before it was saved)
+// gets the same _id and is rejected by the database as a duplicate rather than saved twice.
+Ledger.prototype.takeExpiredDocuments = function() {
+    var documents = new Array(this.expiredCount);
+    var record = 0;
+    var strategyIndex = 0;
+    var i = 0;
+
+    for (i = 0; i < this.expiredCount; i++) {
+        record = this.expiredRecords[i];
+        strategyIndex = this.strategyIndexes[record];
+
+        documents[i] = {
+            _id: this.strategyUuids[strategyIndex] + ':' + this.timestamps[record] + ':' + transactionTypes[this.types[record]],
+            symbol: this.strategySymbols[strategyIndex],
+            strategyUuid: this.strategyUuids[strategyIndex],
+            transactionType: transactionTypes[this.types[record]],
+            timestamp: this.timestamps[record],
+            price: this.prices[record],
+            investment: this.investments[record],
+            profitability: this.profitabilities[record],
+            closePrice: this.closePrices[record],
+            expirationTimestamp: this.expirationTimestamps[record],
+            closeTimestamp: this.closeTimestamps[record],
+            profitLoss: this.profitLosses[record]
+        };
+
+        this.freeRecords[this.freeCount++] = record;
+    }
+
+    this.expiredCount = 0;
+
+    return documents;
+};
+
+module.exports = Ledger;
@@ -0,0 +1,101 @@
+// Number of positions allocated for initially.
+var initialCapacity = 16;
+
+// Open positions ordered by expiration timestamp, held in a ring buffer. Positions almost always expire in
+// the order they are opened, so adding one is normally O(1), and closing only touches expired positions.
+// Positions may be position objects or ledger records.
+function Queue() {
+    this.capacity = initialCapacity;
+    this.positions = new Array(this.capacity);
+    this.expirationTimestamps = new Float64Array(this.capacity);
+    this.head = 0;
+    this.length = 0;
+}
+
+Queue.prototype.getCount = function() {
+    return this.length;
+};
+
+// Returns the position at the given index, in expiration order.
+Queue.prototype.get = function(index) {
+    return this.positions[(this.head + index) & (this.capacity - 1)];
+};
+
+// Returns the position that expires first, or null if there are no positions.
+Queue.prototype.peek = function() {
+    return this.length ? this.positions[this.head] : null;
+};
+
+Queue.prototype.getEarliestExpirationTimestamp = function() {
+    return this.length ? this.expirationTimestamps[this.head] : Infinity;
+};
+
+Queue.prototype.push = function(position, expirationTimestamp) {
+    var mask = 0;
+    var index = 0;
+    var previousIndex = 0;
+
+    if (this.length === this.capacity) {
+        this.grow();
+    }
+
+    mask = this.capacity - 1;
+    index = (this.head + this.length) & mask;
+
+    // Move positions that expire later back one slot. Positions expiring at the same time stay in the
+    // order they were added.
+    while (index !== this.head) {
+        previousIndex = (index - 1) & mask;
+
+        if (this.expirationTimestamps[previousIndex] <= expirationTimestamp) {
+            break;
+        }
+
+        this.positions[index] = this.positions[previousIndex];
+        this.expirationTimestamps[index] = this.expirationTimestamps[previousIndex];
+        index = previousIndex;
+    }
+
+    this.positions[index] = position;
+    this.expirationTimestamps[index] = expirationTimestamp;
+    this.length++;
+};
+
+// Removes and returns the position that expires first.
+Queue.prototype.shift = function() {
+    var position = null;
+
+    if (!this.length) {
+        return null;
+    }
+
+    position = this.positions[this.head];
+
+    // Release the reference.
+    this.positions[this.head] = null;
+
+    this.head = (this.head + 1) & (this.capacity - 1);
+    this.length--;
+
+    return position;
+};
+
+Queue.prototype.grow = function() {
+    var positions = new Array(this.capacity * 2);
+    var expirationTimestamps = new Float64Array(this.capacity * 2);
+    var index = 0;
+    var i = 0;
+
+    for (i = 0; i < this.length; i++) {
+        index = (this.head + i) & (this.capacity - 1);
+        positions[i] = this.positions[index];
+        expirationTimestamps[i] = this.expirationTimestamps[index];
+    }
+
+    this.positions = positions;
+    this.expirationTimestamps = expirationTimestamps;
+    this.capacity *= 2;
+    this.head = 0;
+};
+
+module.exports = Queue;
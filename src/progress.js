@@ -0,0 +1,31 @@
+// Minimum number of milliseconds between progress updates.
+var defaultInterval = 250;
+
+// Returns a function that writes a progress message at a column of the current line, overwriting the previous
+// message. Writing to the terminal for every data point, chunk or candidate is measurable overhead, so
+// updates more frequent than the interval are dropped unless forced (as they should be for the last one).
+module.exports.create = function(column, interval) {
+    var lastTime = 0;
+
+    interval = interval === undefined ? defaultInterval : interval;
+
+    return function(message, force) {
+        var now = Date.now();
+
+        if (!force && now - lastTime < interval) {
+            return;
+        }
+
+        lastTime = now;
+
+        // Output that is not a terminal cannot be overwritten, so start a new line instead.
+        if (process.stdout.cursorTo) {
+            process.stdout.cursorTo(column);
+        }
+        else {
+            process.stdout.write('\n');
+        }
+
+        process.stdout.write(message);
+    };
+};
@@ -1,9 +1,12 @@
 var fs = require('fs');
+var PositionQueue = require('../positions/Queue');
+var constraints = require('../constraints');
 
 function Base(symbol) {
     this.symbol = symbol;
     this.studies = [];
-    this.openPositions = [];
+    this.openPositions = new PositionQueue();
+    this.expiredPositions = [];
     this.profitLoss = 0.0;
     this.cumulativeData = [];
     this.cumulativeDataCount = 0;
@@ -13,6 +16,11 @@ function Base(symbol) {
     this.consecutiveLosses = 0;
     this.maximumConsecutiveLosses = 0;
     this.minimumProfitLoss = 99999;
+
+    // Rules for retiring the strategy once its results can no longer satisfy the constraints they are
+    // filtered with (see constraints.getPruningRules()), and whether it has been.
+    this.pruningRules = null;
+    this.pruned = false;
 }
 
 Base.prototype.getSymbol = function() {
@@ -41,6 +49,14 @@ Base.prototype.getProfitLoss = function() {
     return this.profitLoss;
 };
 
+Base.prototype.setPruningRules = function(pruningRules) {
+    this.pruningRules = pruningRules && pruningRules.length ? pruningRules : null;
+};
+
+Base.prototype.isPruned = function() {
+    return this.pruned;
+};
+
 Base.prototype.getWinRate = function() {
     if (this.winCount + this.loseCount === 0) {
         return 0;
@@ -70,58 +86,66 @@ Base.prototype.getResults = function() {
 
 Base.prototype.addPosition = function(position) {
     // Also track this position in the list of open positions.
-    this.openPositions[this.openPositions.length] = position;
+    this.openPositions.push(position, position.getExpirationTimestamp());
 };
 
+Base.prototype.getEarliestExpirationTimestamp = function() {
+    return this.openPositions.getEarliestExpirationTimestamp();
+};
+
+// Closes expired positions, returning them. The returned array is reused, so it is only valid until the
+// next call.
 Base.prototype.closeExpiredPositions = function(price, timestamp) {
     var self = this;
+    var expiredPositions = self.expiredPositions;
+    var position = null;
 
-    // Use a copy so that items can be removed from the original without messing up the loop.
-    var openPositionsCopy = self.openPositions.slice();
+    expiredPositions.length = 0;
 
-    var expiredPositions = [];
+    // Open positions are ordered by expiration, so only the positions at the front need checking.
+    while (self.openPositions.getCount() && self.openPositions.peek().getHasExpired(timestamp)) {
+        // Remove the position from the list of open positions.
+        position = self.openPositions.shift();
 
-    // Iterate over open positions.
-    openPositionsCopy.forEach(function(position, index) {
-        var profitLoss = 0.0;
+        // Close the position since it is open and has expired.
+        position.close(price, timestamp);
 
-        if (position.getHasExpired(timestamp)) {
-            // Close the position since it is open and has expired.
-            position.close(price, timestamp);
+        self.recordProfitLoss(position.getInvestment(), position.getProfitLoss());
 
-            self.profitLoss -= position.getInvestment();
-
-            // Add the profit/loss for this position to the profit/loss for this strategy.
-            profitLoss = position.getProfitLoss();
-            self.profitLoss += profitLoss;
+        expiredPositions[expiredPositions.length] = position;
+    }
 
-            if (profitLoss > position.getInvestment()) {
-                self.winCount++;
-                self.consecutiveLosses = 0;
-            }
-            if (profitLoss === 0) {
-                self.loseCount++;
-                self.consecutiveLosses++;
-            }
+    return expiredPositions;
+};
 
-            // Track minimum profit/loss.
-            if (profitLoss < self.minimumProfitLoss) {
-                self.minimumProfitLoss = profitLoss;
-            }
+// Adds the profit/loss for a closed position to the results for this strategy.
+Base.prototype.recordProfitLoss = function(investment, profitLoss) {
+    this.profitLoss -= investment;
+    this.profitLoss += profitLoss;
 
-            // Track the maximum consecutive losses.
-            if (self.consecutiveLosses > self.maximumConsecutiveLosses) {
-                self.maximumConsecutiveLosses = self.consecutiveLosses;
-            }
+    if (profitLoss > investment) {
+        this.winCount++;
+        this.consecutiveLosses = 0;
+    }
+    if (profitLoss === 0) {
+        this.loseCount++;
+        this.consecutiveLosses++;
+    }
 
-            expiredPositions[expiredPositions.length] = position;
+    // Track minimum profit/loss.
+    if (profitLoss < this.minimumProfitLoss) {
+        this.minimumProfitLoss = profitLoss;
+    }
 
-            // Remove the position from the list of open positions.
-            self.openPositions.splice(index, 1);
-        }
-    });
+    // Track the maximum consecutive losses.
+    if (this.consecutiveLosses > this.maximumConsecutiveLosses) {
+        this.maximumConsecutiveLosses = this.consecutiveLosses;
+    }
 
-    return expiredPositions;
+    // Results only change as positions are closed, so this is where a strategy can be found to be hopeless.
+    if (this.pruningRules && !this.pruned && constraints.breaksPruningRules(this.getResults(), this.pruningRules)) {
+        this.pruned = true;
+    }
 };
 
 Base.prototype.setShowTrades = function(showTrades) {
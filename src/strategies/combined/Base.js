@@ -1,4 +1,6 @@
 var StrategyBase = require('../Base');
+var Call = require('../../positions/Call');
+var Put = require('../../positions/Put');
 
 function Base(symbol, configurations) {
     this.constructor = Base;
@@ -10,6 +12,68 @@ function Base(symbol, configurations) {
 // Create a copy of the Base "class" prototype for use in this "class."
 Base.prototype = Object.create(StrategyBase.prototype);
 
+// Properties saved by getState(), along with open positions.
+Base.prototype.stateProperties = [
+    'profitLoss',
+    'winCount',
+    'loseCount',
+    'consecutiveLosses',
+    'maximumConsecutiveLosses',
+    'minimumProfitLoss',
+    'tickPreviousDataPoint'
+];
+
+// Returns the state of the strategy part way through the data, as something that can be saved as JSON.
+Base.prototype.getState = function() {
+    var self = this;
+    var state = {
+        openPositions: []
+    };
+    var position = null;
+    var i = 0;
+
+    self.stateProperties.forEach(function(property) {
+        if (self[property] !== undefined) {
+            state[property] = self[property];
+        }
+    });
+
+    for (i = 0; i < self.openPositions.getCount(); i++) {
+        position = self.openPositions.get(i);
+
+        state.openPositions.push({
+            type: position.getTransactionType(),
+            timestamp: position.getTimestamp(),
+            price: position.getPrice(),
+            investment: position.getInvestment(),
+            profitability: position.getProfitability(),
+            expirationTimestamp: position.getExpirationTimestamp()
+        });
+    }
+
+    return state;
+};
+
+// Restores state returned by getState().
+Base.prototype.setState = function(state) {
+    var self = this;
+
+    self.stateProperties.forEach(function(property) {
+        if (state[property] !== undefined) {
+            self[property] = state[property];
+        }
+    });
+
+    state.openPositions.forEach(function(openPosition) {
+        var positionFn = openPosition.type === 'PUT' ? Put : Call;
+        var expirationMinutes = (openPosition.expirationTimestamp - openPosition.timestamp) / (60 * 1000);
+        var position = new positionFn(self.getSymbol(), openPosition.timestamp, openPosition.price, openPosition.investment, openPosition.profitability, expirationMinutes);
+
+        position.setShowTrades(self.getShowTrades());
+        self.addPosition(position);
+    });
+};
+
 Base.prototype.tick = function(dataPoint) {
     if (this.tickPreviousDataPoint) {
         // Simulate expiry of and profit/loss related to positions held.
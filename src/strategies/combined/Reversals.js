@@ -7,185 +7,226 @@ function ReversalsCombined(symbol, configurations) {
     Base.call(this, symbol, configurations);
 
     this.configurations = configurations;
+    this.investment = 0.0;
+    this.putNextTick = false;
+    this.callNextTick = false;
 }
 
 ReversalsCombined.prototype = Object.create(Base.prototype);
 
+ReversalsCombined.prototype.stateProperties = Base.prototype.stateProperties.concat([
+    'investment',
+    'putNextTick',
+    'callNextTick'
+]);
+
 ReversalsCombined.prototype.backtest = function(data, investment, profitability) {
-    var self = this;
-    var expirationMinutes = 5;
-    var putNextTick = false;
-    var callNextTick = false;
-    var putThisConfiguration = false;
-    var callThisConfiguration = false;
-    var previousDataPoint;
-    var dataPointCount = data.length;
-    var previousDay = -1;
-    var currentDay = -1;
+    return ReversalsCombined.backtestAll([this], data, investment, profitability)[0];
+};
 
-    // For every data point...
-    data.forEach(function(dataPoint, index) {
-        var position = null;
-        var timestampHour = new Date(dataPoint.timestamp).getHours();
-        var timestampMinute = new Date(dataPoint.timestamp).getMinutes();
+// Backtests several strategies in one pass over the data. Each strategy is a separate lane with its own
+// positions, investment, and results, and gets the same results as backtesting it alone would.
+ReversalsCombined.backtestAll = function(strategies, data, investment, profitability) {
+    var dataPointCount = data.length;
+    var cursor = ReversalsCombined.startAll(strategies, investment);
+    var i = 0;
 
-        currentDay = new Date(dataPoint.timestamp).getDay();
+    // For every data point, backtest every strategy.
+    for (i = 0; i < dataPointCount; i++) {
+        ReversalsCombined.backtestAllDataPoint(strategies, data[i], cursor, i < dataPointCount - 1, profitability);
+    }
 
-        if (currentDay !== previousDay) {
-            investment = self.profitLoss * 0.02;
-        }
+    return strategies.map(function(strategy) {
+        return strategy.getResults();
+    });
+};
 
-        previousDay = currentDay;
+// Sets up strategies to be backtested a data point at a time with backtestAllDataPoint(), returning the
+// cursor to pass to it, which tracks where in the data the strategies are.
+ReversalsCombined.startAll = function(strategies, investment) {
+    strategies.forEach(function(strategy) {
+        strategy.investment = investment;
+        strategy.putNextTick = false;
+        strategy.callNextTick = false;
+    });
 
-        // Simulate the next tick.
-        self.tick(dataPoint);
+    return {
+        previousDataPoint: undefined,
+        previousDay: -1
+    };
+};
 
-        // Only trade when the profitability is highest (11:30pm - 4pm CST).
-        // Note that MetaTrader automatically converts timestamps to the current timezone in exported CSV files.
-        if (timestampHour >= 0 && (timestampHour < 7 || (timestampHour === 7 && timestampMinute < 30))) {
-            // Track the current data point as the previous data point for the next tick.
-            previousDataPoint = dataPoint;
+// Backtests every strategy on the next data point. Positions are only opened if there is a data point
+// after this one, which for live data there always will be.
+ReversalsCombined.backtestAllDataPoint = function(strategies, dataPoint, cursor, hasNextDataPoint, profitability) {
+    var strategyCount = strategies.length;
+    var date = new Date(dataPoint.timestamp);
+    var timestampHour = date.getHours();
+    var timestampMinute = date.getMinutes();
+    var currentDay = date.getDay();
+    var isNewDay = currentDay !== cursor.previousDay;
+    var isTradingTime = false;
+    var j = 0;
+
+    cursor.previousDay = currentDay;
+
+    // Only trade when the profitability is highest (11:30pm - 4pm CST).
+    // Note that MetaTrader automatically converts timestamps to the current timezone in exported CSV files.
+    isTradingTime = !(timestampHour >= 0 && (timestampHour < 7 || (timestampHour === 7 && timestampMinute < 30)));
+
+    for (j = 0; j < strategyCount; j++) {
+        strategies[j].backtestDataPoint(dataPoint, cursor.previousDataPoint, hasNextDataPoint, isNewDay, isTradingTime, profitability);
+    }
+
+    // Track the current data point as the previous data point for the next tick.
+    cursor.previousDataPoint = dataPoint;
+};
 
-            self.putNextTick = false;
-            self.callNextTick = false;
+ReversalsCombined.prototype.backtestDataPoint = function(dataPoint, previousDataPoint, hasNextDataPoint, isNewDay, isTradingTime, profitability) {
+    var self = this;
+    var expirationMinutes = 5;
+    var position = null;
+
+    if (isNewDay) {
+        self.investment = self.profitLoss * 0.02;
+    }
+
+    // Simulate the next tick.
+    self.tick(dataPoint);
+
+    // Signals from before trading stopped carry over to when it starts again.
+    if (!isTradingTime) {
+        return;
+    }
+
+    if (previousDataPoint && hasNextDataPoint) {
+        if (self.putNextTick) {
+            // Create a new position.
+            position = new Put(self.getSymbol(), previousDataPoint.timestamp, previousDataPoint.close, self.investment, profitability, expirationMinutes);
+            position.setShowTrades(self.getShowTrades());
+            self.addPosition(position);
+        }
 
-            return;
+        if (self.callNextTick) {
+            // Create a new position.
+            position = new Call(self.getSymbol(), previousDataPoint.timestamp, previousDataPoint.close, self.investment, profitability, expirationMinutes)
+            position.setShowTrades(self.getShowTrades());
+            self.addPosition(position);
         }
+    }
 
-        if (previousDataPoint && index < dataPointCount - 1) {
-            if (putNextTick) {
-                // Create a new position.
-                position = new Put(self.getSymbol(), previousDataPoint.timestamp, previousDataPoint.close, investment, profitability, expirationMinutes);
-                position.setShowTrades(self.getShowTrades());
-                self.addPosition(position);
-            }
+    self.putNextTick = false;
+    self.callNextTick = false;
+
+    // For every configuration...
+    self.configurations.forEach(function(configuration) {
+        var putThisConfiguration = true;
+        var callThisConfiguration = true;
 
-            if (callNextTick) {
-                // Create a new position.
-                position = new Call(self.getSymbol(), previousDataPoint.timestamp, previousDataPoint.close, investment, profitability, expirationMinutes)
-                position.setShowTrades(self.getShowTrades());
-                self.addPosition(position);
+        if (configuration.ema200 && configuration.ema100) {
+            if (!dataPoint.ema200 || !dataPoint.ema100) {
+                putThisConfiguration = false;
+                callThisConfiguration = false;
             }
-        }
 
-        putNextTick = false;
-        callNextTick = false;
+            // Determine if a downtrend is not occurring.
+            if (putThisConfiguration && dataPoint.ema200 < dataPoint.ema100) {
+                putThisConfiguration = false;
+            }
 
-        // For every configuration...
-        self.configurations.forEach(function(configuration) {
-            putThisConfiguration = true;
-            callThisConfiguration = true;
+            // Determine if an uptrend is not occurring.
+            if (callThisConfiguration && dataPoint.ema200 > dataPoint.ema100) {
+                callThisConfiguration = false;
+            }
+        }
+        if (configuration.ema100 && configuration.ema50) {
+            if (!dataPoint.ema100 || !dataPoint.ema50) {
+                putThisConfiguration = false;
+                callThisConfiguration = false;
+            }
 
-            if (configuration.ema200 && configuration.ema100) {
-                if (!dataPoint.ema200 || !dataPoint.ema100) {
-                    putThisConfiguration = false;
-                    callThisConfiguration = false;
-                }
+            // Determine if a downtrend is not occurring.
+            if (putThisConfiguration && dataPoint.ema100 < dataPoint.ema50) {
+                putThisConfiguration = false;
+            }
 
-                // Determine if a downtrend is not occurring.
-                if (putThisConfiguration && dataPoint.ema200 < dataPoint.ema100) {
-                    putThisConfiguration = false;
-                }
+            // Determine if an uptrend is not occurring.
+            if (callThisConfiguration && dataPoint.ema100 > dataPoint.ema50) {
+                callThisConfiguration = false;
+            }
+        }
+        if (configuration.ema50 && configuration.sma13) {
+            if (!dataPoint.ema50 || !dataPoint.sma13) {
+                putThisConfiguration = false;
+                callThisConfiguration = false;
+            }
 
-                // Determine if an uptrend is not occurring.
-                if (callThisConfiguration && dataPoint.ema200 > dataPoint.ema100) {
-                    callThisConfiguration = false;
-                }
+            // Determine if a downtrend is not occurring.
+            if (putThisConfiguration && dataPoint.ema50 < dataPoint.sma13) {
+                putThisConfiguration = false;
             }
-            if (configuration.ema100 && configuration.ema50) {
-                if (!dataPoint.ema100 || !dataPoint.ema50) {
-                    putThisConfiguration = false;
-                    callThisConfiguration = false;
-                }
 
-                // Determine if a downtrend is not occurring.
-                if (putThisConfiguration && dataPoint.ema100 < dataPoint.ema50) {
+            // Determine if an uptrend is not occurring.
+            if (callThisConfiguration && dataPoint.ema50 > dataPoint.sma13) {
+                callThisConfiguration = false;
+            }
+        }
+        if (configuration.rsi) {
+            if (typeof dataPoint[configuration.rsi.rsi] === 'number') {
+                // Determine if RSI is not above the overbought line.
+                if (putThisConfiguration && dataPoint[configuration.rsi.rsi] <= configuration.rsi.overbought) {
                     putThisConfiguration = false;
                 }
 
-                // Determine if an uptrend is not occurring.
-                if (callThisConfiguration && dataPoint.ema100 > dataPoint.ema50) {
+                // Determine if RSI is not below the oversold line.
+                if (callThisConfiguration && dataPoint[configuration.rsi.rsi] >= configuration.rsi.oversold) {
                     callThisConfiguration = false;
                 }
             }
-            if (configuration.ema50 && configuration.sma13) {
-                if (!dataPoint.ema50 || !dataPoint.sma13) {
-                    putThisConfiguration = false;
-                    callThisConfiguration = false;
-                }
-
-                // Determine if a downtrend is not occurring.
-                if (putThisConfiguration && dataPoint.ema50 < dataPoint.sma13) {
+            else {
+                putThisConfiguration = false;
+                callThisConfiguration = false;
+            }
+        }
+        if (configuration.stochastic) {
+            if (typeof dataPoint[configuration.stochastic.K] === 'number' && typeof dataPoint[configuration.stochastic.D] === 'number') {
+                // Determine if stochastic is not above the overbought line.
+                if (putThisConfiguration && (dataPoint[configuration.stochastic.K] <= configuration.stochastic.overbought || dataPoint[configuration.stochastic.D] <= configuration.stochastic.overbought)) {
                     putThisConfiguration = false;
                 }
 
-                // Determine if an uptrend is not occurring.
-                if (callThisConfiguration && dataPoint.ema50 > dataPoint.sma13) {
+                // Determine if stochastic is not below the oversold line.
+                if (callThisConfiguration && (dataPoint[configuration.stochastic.K] >= configuration.stochastic.oversold || dataPoint[configuration.stochastic.D] >= configuration.stochastic.oversold)) {
                     callThisConfiguration = false;
                 }
             }
-            if (configuration.rsi) {
-                if (typeof dataPoint[configuration.rsi.rsi] === 'number') {
-                    // Determine if RSI is not above the overbought line.
-                    if (putThisConfiguration && dataPoint[configuration.rsi.rsi] <= configuration.rsi.overbought) {
-                        putThisConfiguration = false;
-                    }
-
-                    // Determine if RSI is not below the oversold line.
-                    if (callThisConfiguration && dataPoint[configuration.rsi.rsi] >= configuration.rsi.oversold) {
-                        callThisConfiguration = false;
-                    }
-                }
-                else {
-                    putThisConfiguration = false;
-                    callThisConfiguration = false;
-                }
+            else {
+                putThisConfiguration = false;
+                callThisConfiguration = false;
             }
-            if (configuration.stochastic) {
-                if (typeof dataPoint[configuration.stochastic.K] === 'number' && typeof dataPoint[configuration.stochastic.D] === 'number') {
-                    // Determine if stochastic is not above the overbought line.
-                    if (putThisConfiguration && (dataPoint[configuration.stochastic.K] <= configuration.stochastic.overbought || dataPoint[configuration.stochastic.D] <= configuration.stochastic.overbought)) {
-                        putThisConfiguration = false;
-                    }
-
-                    // Determine if stochastic is not below the oversold line.
-                    if (callThisConfiguration && (dataPoint[configuration.stochastic.K] >= configuration.stochastic.oversold || dataPoint[configuration.stochastic.D] >= configuration.stochastic.oversold)) {
-                        callThisConfiguration = false;
-                    }
-                }
-                else {
+        }
+        if (configuration.prChannel) {
+            if (dataPoint[configuration.prChannel.upper] && dataPoint[configuration.prChannel.lower]) {
+                // Determine if the upper regression bound was not breached by the high price.
+                if (putThisConfiguration && (!dataPoint[configuration.prChannel.upper] || dataPoint.high <= dataPoint[configuration.prChannel.upper])) {
                     putThisConfiguration = false;
-                    callThisConfiguration = false;
-                }
-            }
-            if (configuration.prChannel) {
-                if (dataPoint[configuration.prChannel.upper] && dataPoint[configuration.prChannel.lower]) {
-                    // Determine if the upper regression bound was not breached by the high price.
-                    if (putThisConfiguration && (!dataPoint[configuration.prChannel.upper] || dataPoint.high <= dataPoint[configuration.prChannel.upper])) {
-                        putThisConfiguration = false;
-                    }
-
-                    // Determine if the lower regression bound was not breached by the low price.
-                    if (callThisConfiguration && (!dataPoint[configuration.prChannel.lower] || dataPoint.low >= dataPoint[configuration.prChannel.lower])) {
-                        callThisConfiguration = false;
-                    }
                 }
-                else {
-                    putThisConfiguration = false;
+
+                // Determine if the lower regression bound was not breached by the low price.
+                if (callThisConfiguration && (!dataPoint[configuration.prChannel.lower] || dataPoint.low >= dataPoint[configuration.prChannel.lower])) {
                     callThisConfiguration = false;
                 }
             }
+            else {
+                putThisConfiguration = false;
+                callThisConfiguration = false;
+            }
+        }
 
-            // Determine whether to trade next tick.
-            putNextTick = putNextTick || putThisConfiguration;
-            callNextTick = callNextTick || callThisConfiguration;
-        });
-
-        // Track the current data point as the previous data point for the next tick.
-        previousDataPoint = dataPoint;
+        // Determine whether to trade next tick.
+        self.putNextTick = self.putNextTick || putThisConfiguration;
+        self.callNextTick = self.callNextTick || callThisConfiguration;
     });
-
-    return self.getResults();
 };
 
 module.exports = ReversalsCombined;
@@ -1,6 +1,10 @@
 var _ = require('lodash');
 var StrategyBase = require('../Base');
 var PositionModel = require('../../models/Position');
+var Ledger = require('../../positions/Ledger');
+var Checkpoint = require('../../Checkpoint');
+var WriteBuffer = require('../../WriteBuffer');
+var metrics = require('../../metrics');
 var uuid = require('node-uuid');
 
 function Base(symbol, configuration, dataPointCount) {
@@ -9,84 +13,176 @@ function Base(symbol, configuration, dataPointCount) {
 
     this.uuid = uuid.v4();
     this.configuration = configuration;
+    this.configurationHash = Checkpoint.getConfigurationHash(configuration);
     this.dataPointCount = dataPointCount;
+    this.ledgerIndex = Base.ledger.registerStrategy(symbol, this.uuid);
+
+    // Whether closed positions are kept for saving, or only counted towards the results.
+    this.savePositions = true;
 }
 
 // Create a copy of the Base "class" prototype for use in this "class."
 Base.prototype = Object.create(StrategyBase.prototype);
 
-Base.expiredPositionsPool = [];
+// Positions for all optimization strategies in this process.
+Base.ledger = new Ledger();
+
+// Starts a new ledger, once all positions in the current one are saved and no longer needed.
+Base.resetLedger = function() {
+    Base.ledger = new Ledger();
+};
+
+// Positions saved by all optimization strategies in this process, inserted in bulk (see WriteBuffer).
+Base.positionWriter = new WriteBuffer(PositionModel.collection, {metricName: 'mongo.insert.positions'});
+
+// Sets options for inserting positions (such as the write concern). This should be done before any
+// positions are saved.
+Base.configurePositionWrites = function(options) {
+    Base.positionWriter = new WriteBuffer(PositionModel.collection, _.extend({metricName: 'mongo.insert.positions'}, options));
+};
+
+// Properties that make up the state of a strategy part way through a backtest.
+Base.stateProperties = [
+    'uuid',
+    'profitLoss',
+    'winCount',
+    'loseCount',
+    'consecutiveLosses',
+    'maximumConsecutiveLosses',
+    'minimumProfitLoss',
+    'pruned',
+    'previousDataPoint',
+    'tickPreviousDataPoint',
+    'putNextTick',
+    'callNextTick'
+];
 
 Base.prototype.getUuid = function() {
     return this.uuid;
 };
 
-Base.prototype.tick = function(dataPoint, index, callback) {
-    var self = this;
-    var expiredPositions = [];
+// Sets the UUID, for re-running a strategy that has already been backtested.
+Base.prototype.setUuid = function(strategyUuid) {
+    this.uuid = strategyUuid;
+    Base.ledger.setStrategyUuid(this.ledgerIndex, strategyUuid);
+};
 
-    if (self.tickPreviousDataPoint) {
-        // Simulate expiry of and profit/loss related to positions held.
-        expiredPositions = self.closeExpiredPositions(self.tickPreviousDataPoint.close, dataPoint.timestamp - 1000);
+Base.prototype.setSavePositions = function(savePositions) {
+    this.savePositions = savePositions;
+};
 
-        expiredPositions.forEach(function(position) {
-            Base.expiredPositionsPool.push(position);
-        });
+// Opens a position in the ledger.
+Base.prototype.openPosition = function(type, timestamp, price, investment, profitability, expirationMinutes) {
+    var record = Base.ledger.open(type, this.ledgerIndex, timestamp, price, investment, profitability, expirationMinutes);
 
-        self.tickPreviousDataPoint = dataPoint;
+    this.openPositions.push(record, Base.ledger.getExpirationTimestamp(record));
+};
 
-        callback();
-    }
-    else {
-        self.tickPreviousDataPoint = dataPoint;
-        callback();
+// Closes expired positions. Closed positions stay in the ledger until saved, unless they are not being saved.
+Base.prototype.closeExpiredPositions = function(price, timestamp) {
+    var record = 0;
+
+    // Open positions are ordered by expiration, so only the positions at the front need checking.
+    while (this.openPositions.getEarliestExpirationTimestamp() <= timestamp) {
+        record = this.openPositions.shift();
+
+        this.recordProfitLoss(Base.ledger.getInvestment(record), Base.ledger.close(record, price, timestamp));
+
+        if (this.savePositions) {
+            Base.ledger.expire(record);
+        }
+        else {
+            Base.ledger.release(record);
+        }
     }
 };
 
-Base.prototype.getConfiguration = function() {
-    return this.configuration;
-};
+// Returns the state of the strategy (including open positions) as a plain object.
+Base.prototype.getState = function() {
+    var self = this;
+    var state = {
+        openPositions: []
+    };
+    var i = 0;
+
+    Base.stateProperties.forEach(function(property) {
+        if (self[property] !== undefined) {
+            state[property] = self[property];
+        }
+    });
 
-Base.saveExpiredPositionsPool = function(callback) {
-    if (Base.expiredPositionsPool.length === 0) {
-        callback();
-        return;
+    for (i = 0; i < self.openPositions.getCount(); i++) {
+        state.openPositions.push(Base.ledger.getPosition(self.openPositions.get(i)));
     }
 
+    return state;
+};
+
+// Restores state returned by getState().
+Base.prototype.setState = function(state) {
     var self = this;
-    var expiredPositionsBuffer = [];
 
-    expiredPositionsBuffer = _.map(Base.expiredPositionsPool, function(position) {
-        return {
-            symbol: position.getSymbol(),
-            strategyUuid: position.getStrategyUuid(),
-            transactionType: position.getTransactionType(),
-            timestamp: position.getTimestamp(),
-            price: position.getPrice(),
-            investment: position.getInvestment(),
-            profitability: position.getProfitability(),
-            closePrice: position.getClosePrice(),
-            expirationTimestamp: position.getExpirationTimestamp(),
-            closeTimestamp: position.getCloseTimestamp(),
-            profitLoss: position.getProfitLoss()
-        };
+    Base.stateProperties.forEach(function(property) {
+        if (state[property] !== undefined) {
+            self[property] = state[property];
+        }
     });
 
-    Base.expiredPositionsPool.forEach(function(position, index) {
-        Base.expiredPositionsPool[index] = null;
+    // Keep the same UUID so that positions saved before and after the checkpoint belong together.
+    self.setUuid(self.uuid);
+
+    state.openPositions.forEach(function(position) {
+        var record = Base.ledger.restore(position, self.ledgerIndex);
+
+        self.openPositions.push(record, Base.ledger.getExpirationTimestamp(record));
     });
+};
+
+Base.prototype.tick = function(dataPoint, index, callback) {
+    if (this.tickPreviousDataPoint) {
+        // Simulate expiry of and profit/loss related to positions held.
+        this.closeExpiredPositions(this.tickPreviousDataPoint.close, dataPoint.timestamp - 1000);
+    }
+
+    this.tickPreviousDataPoint = dataPoint;
+
+    callback();
+};
+
+Base.prototype.getConfiguration = function() {
+    return this.configuration;
+};
+
+Base.prototype.getConfigurationHash = function() {
+    return this.configurationHash;
+};
+
+// Hands expired positions to the position writer. The callback is called once the writer can take more,
+// which does not mean the positions are in the database yet (see whenPositionsSaved).
+Base.saveExpiredPositionsPool = function(callback) {
+    var expiredPositionsBuffer = [];
 
-    Base.expiredPositionsPool = [];
+    metrics.setGauge('expiredPositions', Base.ledger.getExpiredCount());
 
-    if (expiredPositionsBuffer.length === 0) {
+    if (Base.ledger.getExpiredCount() === 0) {
         callback();
         return;
     }
 
-    PositionModel.collection.insert(expiredPositionsBuffer, function() {
-        expiredPositionsBuffer = [];
-        callback();
-    });
+    expiredPositionsBuffer = Base.ledger.takeExpiredDocuments();
+    metrics.increment('savedPositions', expiredPositionsBuffer.length);
+
+    Base.positionWriter.push(expiredPositionsBuffer, callback);
+};
+
+// Calls back once every position handed to the position writer so far is in the database.
+Base.whenPositionsSaved = function(callback) {
+    Base.positionWriter.whenWritten(callback);
+};
+
+// Inserts any positions waiting in the position writer, calling back once all are in the database.
+Base.flushPositions = function(callback) {
+    Base.positionWriter.flush(callback);
 };
 
 module.exports = Base;
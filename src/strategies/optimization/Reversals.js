@@ -1,7 +1,27 @@
 var _ = require('lodash');
 var Base = require('./Base');
-var Call = require('../../positions/Call');
-var Put = require('../../positions/Put');
+var Ledger = require('../../positions/Ledger');
+var SignalMatrix = require('../../SignalMatrix');
+
+var conditions = SignalMatrix.conditions;
+
+// Only trade when the profitability is highest (11:30pm - 4pm CST).
+// Note that MetaTrader automatically converts timestamps to the current timezone in exported CSV files.
+var tradingHoursCondition = {
+    key: 'reversalsTradingHours',
+    columns: ['timestamp'],
+    test: function(columns, index) {
+        var date = new Date(columns.timestamp[index]);
+        var timestampHour = date.getHours();
+        var timestampMinute = date.getMinutes();
+
+        return !(timestampHour >= 0 && (timestampHour < 7 || (timestampHour === 7 && timestampMinute < 30)));
+    }
+};
+
+// Signal bitsets, reused for each strategy in turn.
+var putSignals = new Uint32Array(0);
+var callSignals = new Uint32Array(0);
 
 function Reversals(symbol, configuration, dataPointCount) {
     this.constructor = Reversals;
@@ -18,12 +38,6 @@ Reversals.prototype = Object.create(Base.prototype);
 // Inherit "static" methods and data from the base constructor function.
 _.extend(Reversals, Base);
 
-Reversals.prototype.addPosition = function(position) {
-    position.setStrategyUuid(this.getUuid());
-
-    Base.prototype.addPosition.call(this, position);
-};
-
 Reversals.prototype.backtest = function(dataPoint, index, investment, profitability, callback) {
     var self = this;
     var expirationMinutes = 5;
@@ -48,12 +62,12 @@ Reversals.prototype.backtest = function(dataPoint, index, investment, profitabil
         if (self.previousDataPoint) {
             if (self.putNextTick) {
                 // Create a new position.
-                self.addPosition(new Put(self.getSymbol(), (dataPoint.timestamp - 1000), self.previousDataPoint.close, investment, profitability, expirationMinutes));
+                self.openPosition(Ledger.PUT, (dataPoint.timestamp - 1000), self.previousDataPoint.close, investment, profitability, expirationMinutes);
             }
 
             if (self.callNextTick) {
                 // Create a new position.
-                self.addPosition(new Call(self.getSymbol(), (dataPoint.timestamp - 1000), self.previousDataPoint.close, investment, profitability, expirationMinutes));
+                self.openPosition(Ledger.CALL, (dataPoint.timestamp - 1000), self.previousDataPoint.close, investment, profitability, expirationMinutes);
             }
         }
 
@@ -187,4 +201,157 @@ Reversals.prototype.backtest = function(dataPoint, index, investment, profitabil
     });
 };
 
+// Returns the conditions that must all hold at a data point for a put or call to be made on the next one.
+Reversals.prototype.getSignalConditions = function() {
+    var configuration = this.configuration;
+    var put = [tradingHoursCondition];
+    var call = [tradingHoursCondition];
+
+    if (this.signalConditions) {
+        return this.signalConditions;
+    }
+
+    // Trend conditions require the averages to be available and not opposing the trade.
+    if (configuration.ema200 && configuration.ema100) {
+        put.push(conditions.notBelow('ema200', 'ema100'));
+        call.push(conditions.notAbove('ema200', 'ema100'));
+    }
+    if (configuration.ema100 && configuration.ema50) {
+        put.push(conditions.notBelow('ema100', 'ema50'));
+        call.push(conditions.notAbove('ema100', 'ema50'));
+    }
+    if (configuration.ema50 && configuration.sma13) {
+        put.push(conditions.notBelow('ema50', 'sma13'));
+        call.push(conditions.notAbove('ema50', 'sma13'));
+    }
+
+    // RSI must be above the overbought line for puts, and below the oversold line for calls.
+    if (configuration.rsi) {
+        put.push(conditions.above(configuration.rsi.rsi, configuration.rsi.overbought));
+        call.push(conditions.below(configuration.rsi.rsi, configuration.rsi.oversold));
+    }
+
+    // Both stochastic values must be above the overbought line for puts, and below the oversold line for calls.
+    if (configuration.stochastic) {
+        put.push(conditions.above(configuration.stochastic.K, configuration.stochastic.overbought));
+        put.push(conditions.above(configuration.stochastic.D, configuration.stochastic.overbought));
+        call.push(conditions.below(configuration.stochastic.K, configuration.stochastic.oversold));
+        call.push(conditions.below(configuration.stochastic.D, configuration.stochastic.oversold));
+    }
+
+    // The high price must breach the upper regression bound for puts, and the low price the lower bound for calls.
+    if (configuration.prChannel) {
+        put.push(conditions.breachesUpper(configuration.prChannel.upper, configuration.prChannel.lower));
+        call.push(conditions.breachesLower(configuration.prChannel.upper, configuration.prChannel.lower));
+    }
+
+    this.signalConditions = {
+        put: put,
+        call: call
+    };
+
+    return this.signalConditions;
+};
+
+// Returns the names of the data columns needed to backtest a block.
+Reversals.prototype.getColumnNames = function() {
+    var signalConditions = this.getSignalConditions();
+    var columnNames = ['timestamp', 'close'];
+
+    signalConditions.put.concat(signalConditions.call).forEach(function(condition) {
+        condition.columns.forEach(function(columnName) {
+            if (columnNames.indexOf(columnName) === -1) {
+                columnNames.push(columnName);
+            }
+        });
+    });
+
+    return columnNames;
+};
+
+// Backtests a block of data points at once using signals from a signal matrix. This gives the same
+// results as calling backtest() for each data point in the block, but skips ahead over data points
+// where there are no signals and no open positions.
+Reversals.prototype.backtestBlock = function(matrix, investment, profitability) {
+    var self = this;
+    var expirationMinutes = 5;
+    var count = matrix.getCount();
+    var columns = matrix.getColumns();
+    var timestamps = columns.timestamp;
+    var closes = columns.close;
+    var signalConditions = self.getSignalConditions();
+    var tradingHours = matrix.getBitset(tradingHoursCondition);
+    var hasPrevious = !!self.tickPreviousDataPoint;
+    var previousClose = hasPrevious ? self.tickPreviousDataPoint.close : 0.0;
+    var putNextTick = self.putNextTick;
+    var callNextTick = self.callNextTick;
+    var timestamp = 0;
+    var nextIndex = 0;
+    var i = 0;
+
+    if (putSignals.length < matrix.getWordCount()) {
+        putSignals = new Uint32Array(matrix.getWordCount());
+        callSignals = new Uint32Array(matrix.getWordCount());
+    }
+
+    matrix.combine(signalConditions.put, putSignals);
+    matrix.combine(signalConditions.call, callSignals);
+
+    for (i = 0; i < count; i++) {
+        // Skip ahead to the next signal if there is nothing else to do.
+        if (!putNextTick && !callNextTick && !self.openPositions.getCount()) {
+            nextIndex = SignalMatrix.findNext(putSignals, callSignals, i, count);
+
+            if (nextIndex === -1) {
+                break;
+            }
+            if (nextIndex > i) {
+                i = nextIndex;
+                previousClose = closes[i - 1];
+                hasPrevious = true;
+            }
+        }
+
+        timestamp = timestamps[i] - 1000;
+
+        // Simulate expiry of and profit/loss related to positions held.
+        if (hasPrevious && self.openPositions.getCount()) {
+            self.closeExpiredPositions(previousClose, timestamp);
+
+            // Stop as soon as the strategy is pruned.
+            if (self.pruned) {
+                break;
+            }
+        }
+
+        if (hasPrevious && SignalMatrix.isSet(tradingHours, i)) {
+            if (putNextTick) {
+                // Create a new position.
+                self.openPosition(Ledger.PUT, timestamp, previousClose, investment, profitability, expirationMinutes);
+            }
+
+            if (callNextTick) {
+                // Create a new position.
+                self.openPosition(Ledger.CALL, timestamp, previousClose, investment, profitability, expirationMinutes);
+            }
+        }
+
+        putNextTick = SignalMatrix.isSet(putSignals, i);
+        callNextTick = SignalMatrix.isSet(callSignals, i);
+        previousClose = closes[i];
+        hasPrevious = true;
+    }
+
+    // Track the last data point as the previous data point for the next block.
+    if (count) {
+        self.tickPreviousDataPoint = self.previousDataPoint = {
+            timestamp: timestamps[count - 1],
+            close: closes[count - 1]
+        };
+    }
+
+    self.putNextTick = putNextTick;
+    self.callNextTick = callNextTick;
+};
+
 module.exports = Reversals;
@@ -1,6 +1,6 @@
 var _ = require('lodash');
 var Base = require('./Base');
-var Call = require('../../positions/Call');
+var Ledger = require('../../positions/Ledger');
 
 function Trend(symbol, configuration, dataPointCount) {
     this.constructor = Trend;
@@ -16,12 +16,6 @@ Trend.prototype = Object.create(Base.prototype);
 // Inherit "static" methods and data from the base constructor function.
 _.extend(Trend, Base);
 
-Trend.prototype.addPosition = function(position) {
-    position.setStrategyUuid(this.getUuid());
-
-    Base.prototype.addPosition.call(this, position);
-};
-
 Trend.prototype.backtest = function(dataPoint, index, investment, profitability, callback) {
     var self = this;
     var expirationMinutes = 5;
@@ -44,7 +38,7 @@ Trend.prototype.backtest = function(dataPoint, index, investment, profitability,
         if (self.previousDataPoint) {
             if (self.callNextTick) {
                 // Create a new position.
-                self.addPosition(new Call(self.getSymbol(), (dataPoint.timestamp - 1000), self.previousDataPoint.close, investment, profitability, expirationMinutes));
+                self.openPosition(Ledger.CALL, (dataPoint.timestamp - 1000), self.previousDataPoint.close, investment, profitability, expirationMinutes);
             }
         }
 
@@ -1,5 +1,6 @@
 var Base = require('./Base');
-var _ = require('lodash');
+var kernels = require('./kernels');
+var intermediates = require('./intermediates');
 
 function AverageDirectionalIndex(inputs, outputMap) {
     this.constructor = AverageDirectionalIndex;
@@ -7,15 +8,17 @@ function AverageDirectionalIndex(inputs, outputMap) {
 
     this.tickIndex = 0;
 
+    // The averages are initialized from the sums of every past TR, +DM, -DM and DX value, so only running
+    // totals of them are kept.
     this.pastValues = {};
-    this.pastValues.TR = [];
+    this.pastValues.TRTotal = 0.0;
     this.pastValues.ADX = 0.0;
     this.pastValues.TR2 = 0.0;
-    this.pastValues.pDM = [];
-    this.pastValues.mDM = [];
+    this.pastValues.pDMTotal = 0.0;
+    this.pastValues.mDMTotal = 0.0;
     this.pastValues.pDM2 = 0.0;
     this.pastValues.mDM2 = 0.0;
-    this.pastValues.DX = [];
+    this.pastValues.DXTotal = 0.0;
 
     if (!inputs.length) {
         throw 'No length input parameter provided to study.';
@@ -25,6 +28,9 @@ function AverageDirectionalIndex(inputs, outputMap) {
 // Create a copy of the Base "class" prototype for use in this "class."
 AverageDirectionalIndex.prototype = Object.create(Base.prototype);
 
+// Kernel for series computation (see kernels.js). studies/index.js chooses the backend.
+AverageDirectionalIndex.prototype.seriesKernel = kernels.js.AverageDirectionalIndex;
+
 AverageDirectionalIndex.prototype.tick = function() {
     var dataSegment = this.getDataSegment(this.getInput('length'));
     var dataSegmentLength = dataSegment.length;
@@ -71,22 +77,16 @@ AverageDirectionalIndex.prototype.tick = function() {
             mDM = 0;
         }
 
-        this.pastValues.TR.push(TR);
-        this.pastValues.pDM.push(pDM);
-        this.pastValues.mDM.push(mDM);
+        this.pastValues.TRTotal += TR;
+        this.pastValues.pDMTotal += pDM;
+        this.pastValues.mDMTotal += mDM;
     }
 
     if (this.tickIndex > this.getInput('length')) {
         if (this.tickIndex === this.getInput('length') + 1) {
-            TR2 = _.reduce(this.pastValues.TR, function(memo, pastTR) {
-                return memo + pastTR;
-            }, 0);
-            pDM2 = _.reduce(this.pastValues.pDM, function(memo, pastPDM) {
-                return memo + pastPDM;
-            }, 0);
-            mDM2 = _.reduce(this.pastValues.mDM, function(memo, pastMDM) {
-                return memo + pastMDM;
-            }, 0);
+            TR2 = this.pastValues.TRTotal;
+            pDM2 = this.pastValues.pDMTotal;
+            mDM2 = this.pastValues.mDMTotal;
         }
         else {
             TR2 = this.pastValues.TR2 - (this.pastValues.TR2 / this.getInput('length')) + TR;
@@ -103,14 +103,12 @@ AverageDirectionalIndex.prototype.tick = function() {
         this.pastValues.TR2 = TR2;
         this.pastValues.pDM2 = pDM2;
         this.pastValues.mDM2 = mDM2;
-        this.pastValues.DX.push(DX);
+        this.pastValues.DXTotal += DX;
     }
 
     if (this.tickIndex >= this.getInput('length') * 2) {
         if (this.tickIndex === this.getInput('length') * 2) {
-            ADX = _.reduce(this.pastValues.DX, function(memo, pastDX) {
-                return memo + pastDX;
-            }, 0) / this.getInput('length');
+            ADX = this.pastValues.DXTotal / this.getInput('length');
         }
         else {
             ADX = ((this.pastValues.ADX * (this.getInput('length') - 1)) + DX) / this.getInput('length');
@@ -126,4 +124,14 @@ AverageDirectionalIndex.prototype.tick = function() {
     return returnValue;
 };
 
+AverageDirectionalIndex.prototype.computeSeries = function(columns) {
+    var outputs = this.createSeriesOutputs(columns.length);
+
+    this.seriesKernel(this, columns.length, intermediates.trueRange(columns), intermediates.plusDirectionalMovement(columns),
+        intermediates.minusDirectionalMovement(columns), columns.resets, outputs[this.getOutputMapping('pDI')],
+        outputs[this.getOutputMapping('mDI')], outputs[this.getOutputMapping('ADX')], this.getInput('length'));
+
+    return outputs;
+};
+
 module.exports = AverageDirectionalIndex;
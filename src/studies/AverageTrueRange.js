@@ -1,5 +1,7 @@
 var _ = require('lodash');
 var Base = require('./Base');
+var kernels = require('./kernels');
+var intermediates = require('./intermediates');
 
 function AverageTrueRange(inputs, outputMap) {
     this.constructor = AverageTrueRange;
@@ -16,6 +18,9 @@ function AverageTrueRange(inputs, outputMap) {
 // Create a copy of the Base "class" prototype for use in this "class."
 AverageTrueRange.prototype = Object.create(Base.prototype);
 
+// Kernel for series computation (see kernels.js). studies/index.js chooses the backend.
+AverageTrueRange.prototype.seriesKernel = kernels.js.AverageTrueRange;
+
 AverageTrueRange.prototype.tick = function() {
     var self = this;
     var dataSegment = self.getDataSegment(self.getInput('length'));
@@ -69,4 +74,13 @@ AverageTrueRange.prototype.tick = function() {
     return returnValue;
 };
 
+AverageTrueRange.prototype.computeSeries = function(columns) {
+    var outputs = this.createSeriesOutputs(columns.length);
+
+    this.seriesKernel(this, columns.length, columns.high, columns.low, intermediates.trueRange(columns), columns.resets,
+        outputs[this.getOutputMapping('atr')], this.getInput('length'));
+
+    return outputs;
+};
+
 module.exports = AverageTrueRange;
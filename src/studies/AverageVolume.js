@@ -32,4 +32,34 @@ AverageVolume.prototype.tick = function() {
     return returnValue;
 };
 
+AverageVolume.prototype.computeSeries = function(columns) {
+    var outputs = this.createSeriesOutputs(columns.length);
+    var averageOutput = outputs[this.getOutputMapping('average')];
+    var volume = columns.volume;
+    var resets = columns.resets;
+    var length = this.getInput('length');
+    var segmentStart = 0;
+    var sum = 0.0;
+    var i = 0;
+    var j = 0;
+
+    for (i = 0; i < columns.length; i++) {
+        if (resets[i]) {
+            segmentStart = i;
+        }
+        if (i - segmentStart + 1 < length) {
+            continue;
+        }
+
+        sum = 0;
+        for (j = i - length + 1; j <= i; j++) {
+            sum += volume[j];
+        }
+
+        averageOutput[i] = sum / length;
+    }
+
+    return outputs;
+};
+
 module.exports = AverageVolume;
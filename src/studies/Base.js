@@ -49,6 +49,44 @@ Base.prototype.tick = function() {
     throw 'tick() not implemented.';
 };
 
+// For studies that keep state across ticks: returns whether the current data continues on from the
+// data seen on the previous tick (rather than having started over).
+Base.prototype.continuesPreviousTick = function() {
+    var continues = this.getPrevious() === this.previousTickDataPoint;
+
+    this.previousTickDataPoint = this.getLast();
+
+    return continues;
+};
+
+// Computes the study over a whole series at once. Columns contain one typed array per price field
+// (timestamp, open, high, low, close, volume), a length, and a resets array flagging each index at
+// which the cumulative data starts over (as it does after a gap). Returns typed arrays keyed by
+// output name, with NaN wherever tick() would not have produced a value, or null if the study does
+// not support series computation (in which case tick() is used instead).
+Base.prototype.computeSeries = function(columns) {
+    return null;
+};
+
+Base.prototype.createSeriesOutputs = function(length) {
+    var outputs = {};
+    var outputKey = '';
+    var values;
+    var i = 0;
+
+    for (outputKey in this.outputMap) {
+        values = new Float64Array(length);
+
+        for (i = 0; i < length; i++) {
+            values[i] = NaN;
+        }
+
+        outputs[this.outputMap[outputKey]] = values;
+    }
+
+    return outputs;
+};
+
 // Source: http://www.strchr.com/standard_deviation_in_one_pass
 Base.prototype.calculateStandardDeviation = function(values) {
     var valuesCount = values.length;
@@ -73,4 +111,158 @@ Base.prototype.calculateStandardDeviation = function(values) {
     return Math.sqrt(variance);
 };
 
+// A fixed-length window over the most recent values of a series, maintained incrementally as values
+// are pushed: running sum and sum of squares over a ring buffer, plus optional monotonic deques for
+// the minimum and maximum. NaN values are kept in the window but excluded from the sums.
+function RollingWindow(length, options) {
+    options = options || {};
+
+    this.length = length;
+    this.values = new Float64Array(length);
+    this.trackMinimum = !!options.minimum;
+    this.trackMaximum = !!options.maximum;
+
+    // Deques hold the positions (push counts) of candidate values, oldest first.
+    this.minimumPositions = this.trackMinimum ? new Float64Array(length) : null;
+    this.maximumPositions = this.trackMaximum ? new Float64Array(length) : null;
+
+    this.reset();
+}
+
+RollingWindow.prototype.reset = function() {
+    this.pushCount = 0;
+    this.count = 0;
+    this.validCount = 0;
+    this.sum = 0.0;
+    this.squaredSum = 0.0;
+    this.minimumStart = 0;
+    this.minimumCount = 0;
+    this.maximumStart = 0;
+    this.maximumCount = 0;
+};
+
+RollingWindow.prototype.push = function(value) {
+    var length = this.length;
+    var slot = this.pushCount % length;
+    var oldValue = 0.0;
+
+    // Drop the oldest value if the window is full.
+    if (this.count === length) {
+        oldValue = this.values[slot];
+
+        if (oldValue === oldValue) {
+            this.sum -= oldValue;
+            this.squaredSum -= oldValue * oldValue;
+            this.validCount--;
+        }
+    }
+    else {
+        this.count++;
+    }
+
+    this.values[slot] = value;
+
+    if (value === value) {
+        this.sum += value;
+        this.squaredSum += value * value;
+        this.validCount++;
+    }
+
+    if (this.trackMinimum) {
+        this.pushDeque(this.minimumPositions, 'minimum', value, -1);
+    }
+    if (this.trackMaximum) {
+        this.pushDeque(this.maximumPositions, 'maximum', value, 1);
+    }
+
+    this.pushCount++;
+
+    // Periodically recalculate the sums from scratch so that rounding errors do not accumulate.
+    if (this.pushCount % length === 0) {
+        this.recalculateSums();
+    }
+};
+
+RollingWindow.prototype.pushDeque = function(positions, name, value, direction) {
+    var length = this.length;
+    var start = this[name + 'Start'];
+    var count = this[name + 'Count'];
+    var lastValue = 0.0;
+
+    // Remove positions that have fallen out of the window.
+    while (count && positions[start] <= this.pushCount - length) {
+        start = (start + 1) % length;
+        count--;
+    }
+
+    if (value === value) {
+        // Remove values that can no longer be the minimum (or maximum) because the new value is better.
+        while (count) {
+            lastValue = this.values[positions[(start + count - 1) % length] % length];
+
+            if (direction * (value - lastValue) < 0) {
+                break;
+            }
+            count--;
+        }
+
+        positions[(start + count) % length] = this.pushCount;
+        count++;
+    }
+
+    this[name + 'Start'] = start;
+    this[name + 'Count'] = count;
+};
+
+RollingWindow.prototype.recalculateSums = function() {
+    var sum = 0.0;
+    var squaredSum = 0.0;
+    var value = 0.0;
+    var i = 0;
+
+    for (i = 0; i < this.count; i++) {
+        value = this.values[i];
+
+        if (value === value) {
+            sum += value;
+            squaredSum += value * value;
+        }
+    }
+
+    this.sum = sum;
+    this.squaredSum = squaredSum;
+};
+
+RollingWindow.prototype.getCount = function() {
+    return this.count;
+};
+
+RollingWindow.prototype.getValidCount = function() {
+    return this.validCount;
+};
+
+RollingWindow.prototype.getSum = function() {
+    return this.sum;
+};
+
+RollingWindow.prototype.getMean = function() {
+    return this.sum / this.validCount;
+};
+
+RollingWindow.prototype.getStandardDeviation = function() {
+    var mean = this.sum / this.validCount;
+
+    // Guard against tiny negative variances caused by rounding.
+    return Math.sqrt(Math.max(this.squaredSum / this.validCount - mean * mean, 0));
+};
+
+RollingWindow.prototype.getMinimum = function() {
+    return this.minimumCount ? this.values[this.minimumPositions[this.minimumStart] % this.length] : NaN;
+};
+
+RollingWindow.prototype.getMaximum = function() {
+    return this.maximumCount ? this.values[this.maximumPositions[this.maximumStart] % this.length] : NaN;
+};
+
 module.exports = Base;
+module.exports.RollingWindow = RollingWindow;
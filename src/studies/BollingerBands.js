@@ -1,5 +1,5 @@
 var Base = require('./Base');
-var _ = require('lodash');
+var RollingWindow = Base.RollingWindow;
 
 function BollingerBands(inputs, outputMap) {
     this.constructor = BollingerBands;
@@ -8,6 +8,8 @@ function BollingerBands(inputs, outputMap) {
     if (!inputs.length) {
         throw 'No length input parameter provided to study.';
     }
+
+    this.closeWindow = new RollingWindow(inputs.length);
 }
 
 // Create a copy of the Base "class" prototype for use in this "class."
@@ -16,21 +18,27 @@ BollingerBands.prototype = Object.create(Base.prototype);
 BollingerBands.prototype.tick = function() {
     var self = this;
     var returnValue = {};
+    var length = self.getInput('length');
     var middle = 0.0;
     var middleStandardDeviation = 0.0;
 
-    var dataSegment = self.getDataSegment(self.getInput('length'));
-    var dataSegmentLength = dataSegment.length;
+    if (self.continuesPreviousTick()) {
+        self.closeWindow.push(self.getLast().close);
+    }
+    else {
+        // Start over using the most recent data.
+        self.closeWindow.reset();
+        self.getDataSegment(length).forEach(function(dataPoint) {
+            self.closeWindow.push(dataPoint.close);
+        });
+    }
 
-    if (dataSegmentLength < self.getInput('length')) {
+    if (self.closeWindow.getCount() < length) {
         return returnValue;
     }
 
-    middle = _.reduce(dataSegment, function(memo, dataPoint) {
-        return memo + dataPoint.close;
-    }, 0) / dataSegmentLength;
-
-    middleStandardDeviation = self.calculateStandardDeviation(_.pluck(dataSegment, 'close'));
+    middle = self.closeWindow.getMean();
+    middleStandardDeviation = self.closeWindow.getStandardDeviation();
 
     returnValue[self.getOutputMapping('middle')] = middle;
 
@@ -43,4 +51,42 @@ BollingerBands.prototype.tick = function() {
     return returnValue;
 };
 
-module.exports = BollingerBands;
\ No newline at end of file
+BollingerBands.prototype.computeSeries = function(columns) {
+    var outputs = this.createSeriesOutputs(columns.length);
+    var middleOutput = outputs[this.getOutputMapping('middle')];
+    var upperOutput = outputs[this.getOutputMapping('upper')];
+    var lowerOutput = outputs[this.getOutputMapping('lower')];
+    var close = columns.close;
+    var resets = columns.resets;
+    var length = this.getInput('length');
+    var deviations = this.getInput('deviations');
+    var closeWindow = this.closeWindow;
+    var middle = 0.0;
+    var middleStandardDeviation = 0.0;
+    var i = 0;
+
+    for (i = 0; i < columns.length; i++) {
+        if (resets[i]) {
+            closeWindow.reset();
+        }
+
+        closeWindow.push(close[i]);
+
+        if (closeWindow.getCount() < length) {
+            continue;
+        }
+
+        middle = closeWindow.getMean();
+        middleStandardDeviation = closeWindow.getStandardDeviation();
+
+        middleOutput[i] = middle;
+
+        // Calculate the upper and lower bands using the deviation factor.
+        upperOutput[i] = middle + (deviations * middleStandardDeviation);
+        lowerOutput[i] = middle - (deviations * middleStandardDeviation);
+    }
+
+    return outputs;
+};
+
+module.exports = BollingerBands;
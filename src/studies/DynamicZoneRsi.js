@@ -1,4 +1,6 @@
 var Base = require('./Base');
+var kernels = require('./kernels');
+var intermediates = require('./intermediates');
 var _ = require('lodash');
 
 function DynamicZoneRsi(inputs, outputMap) {
@@ -12,12 +14,20 @@ function DynamicZoneRsi(inputs, outputMap) {
     this.previousAverageGain = null;
     this.previousAverageLoss = null;
     this.previousRsiValues = [];
-    this.previousRsiMovingAverageValues = [];
+
+    // The standard deviation is taken over every moving average calculated so far, so only running sums
+    // of them are kept.
+    this.movingAverageSum = 0;
+    this.movingAverageSquaredSum = 0;
+    this.movingAverageCount = 0;
 }
 
 // Create a copy of the Base "class" prototype for use in this "class."
 DynamicZoneRsi.prototype = Object.create(Base.prototype);
 
+// Kernel for series computation (see kernels.js). studies/index.js chooses the backend.
+DynamicZoneRsi.prototype.seriesKernel = kernels.js.DynamicZoneRsi;
+
 DynamicZoneRsi.prototype.calculateInitialAverageGain = function(initialDataPoint) {
     var previousDataPoint = initialDataPoint;
 
@@ -74,6 +84,7 @@ DynamicZoneRsi.prototype.tick = function() {
     var rsi = 0.0;
     var previousRsiValuesCount = 0;
     var rsiMovingAverage = 0.0;
+    var mean = 0.0;
     var rsiMovingAverageStandardDeviation = 0.0;
     var returnValue = {};
 
@@ -105,11 +116,12 @@ DynamicZoneRsi.prototype.tick = function() {
         return memo + previousRsi;
     }, 0) / self.getInput('bandsLength');
 
-    // Track the moving average as a previous one.
-    self.previousRsiMovingAverageValues.push(rsiMovingAverage);
-
     // Calculate the standard deviation of the moving average.
-    rsiMovingAverageStandardDeviation = self.calculateStandardDeviation(self.previousRsiMovingAverageValues);
+    self.movingAverageSum += rsiMovingAverage;
+    self.movingAverageSquaredSum += rsiMovingAverage * rsiMovingAverage;
+    self.movingAverageCount++;
+    mean = self.movingAverageSum / self.movingAverageCount;
+    rsiMovingAverageStandardDeviation = Math.sqrt(self.movingAverageSquaredSum / self.movingAverageCount - mean * mean);
 
     // Calculate the upper band using the deviation factor.
     returnValue[self.getOutputMapping('upper')] = rsiMovingAverage + (self.getInput('deviations') * rsiMovingAverageStandardDeviation);
@@ -120,4 +132,14 @@ DynamicZoneRsi.prototype.tick = function() {
     return returnValue;
 };
 
+DynamicZoneRsi.prototype.computeSeries = function(columns) {
+    var outputs = this.createSeriesOutputs(columns.length);
+
+    this.seriesKernel(this, columns.length, columns.close, intermediates.gains(columns), intermediates.losses(columns), columns.resets,
+        outputs[this.getOutputMapping('rsi')], outputs[this.getOutputMapping('upper')], outputs[this.getOutputMapping('lower')],
+        this.getInput('length'), this.getInput('bandsLength'), this.getInput('deviations'));
+
+    return outputs;
+};
+
 module.exports = DynamicZoneRsi;
@@ -1,4 +1,5 @@
 var Base = require('./Base');
+var kernels = require('./kernels');
 
 function Ema(inputs, outputMap) {
     this.constructor = Ema;
@@ -12,6 +13,9 @@ function Ema(inputs, outputMap) {
 // Create a copy of the Base "class" prototype for use in this "class."
 Ema.prototype = Object.create(Base.prototype);
 
+// Kernel for series computation (see kernels.js). studies/index.js chooses the backend.
+Ema.prototype.seriesKernel = kernels.js.Ema;
+
 Ema.prototype.tick = function() {
     var lastDataPoint = this.getLast();
     var K = 0.0;
@@ -34,4 +38,12 @@ Ema.prototype.tick = function() {
     return returnValue;
 };
 
+Ema.prototype.computeSeries = function(columns) {
+    var outputs = this.createSeriesOutputs(columns.length);
+
+    this.seriesKernel(this, columns.length, columns.close, outputs[this.getOutputMapping('ema')], this.getInput('length'));
+
+    return outputs;
+};
+
 module.exports = Ema;
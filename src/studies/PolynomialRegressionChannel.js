@@ -1,6 +1,204 @@
 var Base = require('./Base');
-var _ = require('lodash');
-var regression = require('regression');
+var RollingWindow = Base.RollingWindow;
+var intermediates = require('./intermediates');
+
+// Fit parameters depend only on the window length and degree, so they are calculated once and shared.
+var fitParametersCache = {};
+
+// Returns the shift matrix and weights for a least squares fit over a window of the given length.
+//
+// Window positions are scaled to u = j / (length - 1) so the normal equation sums stay well conditioned.
+// The fitted value at the end of the window (u = 1) is then weights . moments, where
+// moments[k] = sum(u^k * y) and weights solves gram * weights = [1, 1, ...].
+function getFitParameters(length, degree) {
+    var key = length + ':' + degree;
+    var size = degree + 1;
+    var step = length > 1 ? 1 / (length - 1) : 1;
+    var gram = [];
+    var shift = new Float64Array(size * size);
+    var weights = new Float64Array(size);
+    var binomial = 1;
+    var power = 1.0;
+    var maximumRow = 0;
+    var temporary;
+    var factor = 0.0;
+    var sum = 0.0;
+    var i = 0;
+    var j = 0;
+    var k = 0;
+
+    if (fitParametersCache[key]) {
+        return fitParametersCache[key];
+    }
+
+    // Build the gram matrix augmented with a column of ones.
+    for (i = 0; i < size; i++) {
+        gram[i] = [];
+
+        for (j = 0; j < size; j++) {
+            sum = 0;
+            for (k = 0; k < length; k++) {
+                sum += Math.pow(k * step, i + j);
+            }
+            gram[i][j] = sum;
+        }
+        gram[i][size] = 1;
+    }
+
+    // Solve for the weights using Gaussian elimination with partial pivoting.
+    for (i = 0; i < size; i++) {
+        maximumRow = i;
+        for (j = i + 1; j < size; j++) {
+            if (Math.abs(gram[j][i]) > Math.abs(gram[maximumRow][i])) {
+                maximumRow = j;
+            }
+        }
+        temporary = gram[i];
+        gram[i] = gram[maximumRow];
+        gram[maximumRow] = temporary;
+
+        for (j = i + 1; j < size; j++) {
+            factor = gram[j][i] / gram[i][i];
+            for (k = i; k <= size; k++) {
+                gram[j][k] -= factor * gram[i][k];
+            }
+        }
+    }
+    for (i = size - 1; i >= 0; i--) {
+        sum = gram[i][size];
+        for (j = i + 1; j < size; j++) {
+            sum -= gram[i][j] * weights[j];
+        }
+        weights[i] = sum / gram[i][i];
+    }
+
+    // Moving every point back one position turns sum(u^k * y) into sum((u - step)^k * y), which expands
+    // binomially into the lower order moments.
+    for (k = 0; k < size; k++) {
+        binomial = 1;
+        power = Math.pow(-step, k);
+
+        for (j = 0; j <= k; j++) {
+            shift[k * size + j] = binomial * power;
+            binomial = binomial * (k - j) / (j + 1);
+            power = power / -step;
+        }
+    }
+
+    fitParametersCache[key] = {
+        step: step,
+        shift: shift,
+        weights: weights
+    };
+
+    return fitParametersCache[key];
+}
+
+// A least squares polynomial fit over a sliding window, updated as values are added and dropped.
+function RegressionFit(length, degree) {
+    this.length = length;
+    this.degree = degree;
+    this.parameters = getFitParameters(length, degree);
+    this.values = new Float64Array(length);
+    this.moments = new Float64Array(degree + 1);
+    this.shiftedMoments = new Float64Array(degree + 1);
+
+    this.reset();
+}
+
+RegressionFit.prototype.reset = function() {
+    var k = 0;
+
+    this.pushCount = 0;
+    this.count = 0;
+
+    for (k = 0; k <= this.degree; k++) {
+        this.moments[k] = 0;
+    }
+};
+
+RegressionFit.prototype.push = function(value) {
+    var size = this.degree + 1;
+    var shift = this.parameters.shift;
+    var moments = this.moments;
+    var shiftedMoments = this.shiftedMoments;
+    var slot = this.pushCount % this.length;
+    var sum = 0.0;
+    var j = 0;
+    var k = 0;
+
+    // The oldest value sits at u = 0, so it only contributes to the zeroth moment.
+    if (this.count === this.length) {
+        moments[0] -= this.values[slot];
+    }
+    else {
+        this.count++;
+    }
+
+    // Move the remaining values back one position.
+    for (k = 0; k < size; k++) {
+        sum = 0;
+        for (j = 0; j <= k; j++) {
+            sum += shift[k * size + j] * moments[j];
+        }
+        shiftedMoments[k] = sum;
+    }
+
+    // Add the new value at u = 1.
+    for (k = 0; k < size; k++) {
+        moments[k] = shiftedMoments[k] + value;
+    }
+
+    this.values[slot] = value;
+    this.pushCount++;
+
+    // Periodically recalculate the moments from scratch so that rounding errors do not accumulate.
+    if (this.pushCount % this.length === 0) {
+        this.recalculateMoments();
+    }
+};
+
+RegressionFit.prototype.recalculateMoments = function() {
+    var step = this.parameters.step;
+    var moments = this.moments;
+    var position = 0.0;
+    var power = 1.0;
+    var value = 0.0;
+    var age = 0;
+    var k = 0;
+
+    for (k = 0; k <= this.degree; k++) {
+        moments[k] = 0;
+    }
+
+    for (age = 0; age < this.count; age++) {
+        value = this.values[(this.pushCount - 1 - age) % this.length];
+        position = 1 - age * step;
+        power = 1;
+
+        for (k = 0; k <= this.degree; k++) {
+            moments[k] += power * value;
+            power *= position;
+        }
+    }
+};
+
+RegressionFit.prototype.isReady = function() {
+    return this.count === this.length;
+};
+
+// Returns the fitted value for the most recent point in the window.
+RegressionFit.prototype.getValue = function() {
+    var weights = this.parameters.weights;
+    var value = 0.0;
+    var k = 0;
+
+    for (k = 0; k <= this.degree; k++) {
+        value += weights[k] * this.moments[k];
+    }
+
+    return value;
+};
 
 function PolynomialRegressionChannel(inputs, outputMap) {
     this.constructor = PolynomialRegressionChannel;
@@ -9,118 +207,154 @@ function PolynomialRegressionChannel(inputs, outputMap) {
     if (!inputs.length) {
         throw 'No length input parameter provided to study.';
     }
+
+    this.fit = new RegressionFit(inputs.length, inputs.degree);
+    this.regressionWindow = new RollingWindow(inputs.length);
+    this.previousRegression = NaN;
 }
 
 // Create a copy of the Base "class" prototype for use in this "class."
 PolynomialRegressionChannel.prototype = Object.create(Base.prototype);
 
-PolynomialRegressionChannel.prototype.calculateRegression = function(values, degree) {
-    var data = [];
-    var regressionOutput;
-    var valuesCount = values.length;
-    var i = 0;
+// Returns the regression value for each data point (NaN where there is not enough data), sharing
+// the result between studies with the same length and degree.
+PolynomialRegressionChannel.getRegressionSeries = function(columns, length, degree) {
+    return intermediates.get(columns, 'regression' + length + '_' + degree, function() {
+        var series = new Float64Array(columns.length);
+        var fit = new RegressionFit(length, degree);
+        var close = columns.close;
+        var resets = columns.resets;
+        var i = 0;
 
-    // Format the data in a way the regression library expects.
-    for (i = 0; i < valuesCount; i++) {
-        data[i] = [i, values[i]];
-    }
+        for (i = 0; i < columns.length; i++) {
+            if (resets[i]) {
+                fit.reset();
+            }
 
-    // Use the library to calculate the regression.
-    regressionOutput = regression('polynomial', data, degree);
+            fit.push(close[i]);
+            series[i] = fit.isReady() ? fit.getValue() : NaN;
+        }
 
-    // Return the last regression data point.
-    return regressionOutput.points[regressionOutput.points.length - 1][1];
+        return series;
+    });
 };
 
-// Source: http://www.strchr.com/standard_deviation_in_one_pass
-PolynomialRegressionChannel.prototype.calculateStandardDeviation = function(values) {
-    var valuesCount = values.length;
-    var sum = 0;
-    var squaredSum = 0;
-    var mean = 0.0;
-    var variance = 0.0;
-    var i = 0;
+PolynomialRegressionChannel.prototype.reset = function() {
+    this.fit.reset();
+    this.regressionWindow.reset();
+    this.previousRegression = NaN;
+};
+
+// Adds a data point, returning the regression and its standard deviation (NaN where unavailable).
+PolynomialRegressionChannel.prototype.step = function(close) {
+    var regressionValue = NaN;
+    var regressionStandardDeviation = NaN;
 
-    if (valuesCount === 0) {
-        return 0.0;
+    this.fit.push(close);
+
+    if (this.fit.isReady()) {
+        regressionValue = this.fit.getValue();
     }
 
-    for (i = 0; i < valuesCount; ++i) {
-       sum += values[i];
-       squaredSum += values[i] * values[i];
+    // Only points that actually have regression data count towards the standard deviation.
+    this.regressionWindow.push(regressionValue || NaN);
+
+    // If there is no previous regression data available, then skip.
+    if (this.previousRegression && regressionValue === regressionValue) {
+        regressionStandardDeviation = this.regressionWindow.getStandardDeviation();
     }
 
-    mean = sum / valuesCount;
-    variance = squaredSum / valuesCount - mean * mean;
+    this.previousRegression = regressionValue;
 
-    return Math.sqrt(variance);
+    return {
+        regression: regressionValue,
+        standardDeviation: regressionStandardDeviation
+    };
 };
 
 PolynomialRegressionChannel.prototype.tick = function() {
     var self = this;
-    var dataSegment = self.getDataSegment(self.getInput('length'));
-    var dataSegmentLength = dataSegment.length;
-    var regressionValue = 0.0;
-    var regressionStandardDeviation = 0.0;
-    var upperValue = 0.0;
-    var lowerValue = 0.0;
-    var pastPrices = [];
-    var pastRegressions = [];
+    var length = self.getInput('length');
+    var deviations = self.getInput('deviations');
+    var values = null;
     var returnValue = {};
-    var dataPointRegression;
-    var i = 0;
-    var j = 0;
-    var regressionOutputName = self.getOutputMapping('regression');
 
-    if (dataSegmentLength < self.getInput('length')) {
+    if (self.continuesPreviousTick()) {
+        values = self.step(self.getLast().close);
+    }
+    else {
+        // Start over using the most recent data, including enough for previous regression values.
+        self.reset();
+        self.getDataSegment(length * 2 - 1).forEach(function(dataPoint) {
+            values = self.step(dataPoint.close);
+        });
+    }
+
+    if (values.regression !== values.regression) {
         return returnValue;
     }
 
-    // Calculate the regression.
-    pastPrices = _.map(dataSegment, function(dataPoint) {
-        return dataPoint.close;
-    });
-    regressionValue = self.calculateRegression(pastPrices, self.getInput('degree'));
-
-    // Calculate the standard deviations of the regression. If there is no regression data
-    // available, then skip.
-    if (self.getInput('deviations') && dataSegment[dataSegmentLength - 2][regressionOutputName]) {
-        // Build an array of regression data using only points that actually have regression data.
-        for (i = 0; i < dataSegmentLength; i++) {
-            if (i === dataSegmentLength - 1) {
-                // Current regression.
-                dataPointRegression = regressionValue;
-            }
-            else {
-                // A previous regression.
-                dataPointRegression = dataSegment[i][regressionOutputName];
-            }
+    returnValue[self.getOutputMapping('regression')] = values.regression;
 
-            if (dataPointRegression) {
-                pastRegressions[j++] = dataPointRegression;
-            }
+    if (deviations) {
+        if (values.standardDeviation === values.standardDeviation) {
+            // Calculate the upper and lower values.
+            returnValue[self.getOutputMapping('upper')] = values.regression + (values.standardDeviation * deviations);
+            returnValue[self.getOutputMapping('lower')] = values.regression - (values.standardDeviation * deviations);
+        }
+        else {
+            returnValue[self.getOutputMapping('upper')] = '';
+            returnValue[self.getOutputMapping('lower')] = '';
         }
+    }
 
-        // Calculate the standard deviation from the regressions.
-        regressionStandardDeviation = self.calculateStandardDeviation(pastRegressions);
+    return returnValue;
+};
 
-        // Calculate the upper and lower values.
-        upperValue = regressionValue + (regressionStandardDeviation * self.getInput('deviations'));
-        lowerValue = regressionValue - (regressionStandardDeviation * self.getInput('deviations'));
-    }
-    else {
-        upperValue = '';
-        lowerValue = '';
+PolynomialRegressionChannel.prototype.computeSeries = function(columns) {
+    var outputs = this.createSeriesOutputs(columns.length);
+    var regressionOutput = outputs[this.getOutputMapping('regression')];
+    var upperOutput = outputs[this.getOutputMapping('upper')];
+    var lowerOutput = outputs[this.getOutputMapping('lower')];
+    var resets = columns.resets;
+    var deviations = this.getInput('deviations');
+    var regressionSeries = PolynomialRegressionChannel.getRegressionSeries(columns, this.getInput('length'), this.getInput('degree'));
+    var regressionWindow = this.regressionWindow;
+    var previousRegression = NaN;
+    var regressionValue = 0.0;
+    var regressionStandardDeviation = 0.0;
+    var i = 0;
+
+    regressionOutput.set(regressionSeries);
+
+    if (!deviations) {
+        return outputs;
     }
 
-    returnValue[regressionOutputName] = regressionValue;
+    for (i = 0; i < columns.length; i++) {
+        if (resets[i]) {
+            regressionWindow.reset();
+            previousRegression = NaN;
+        }
 
-    if (self.getInput('deviations')) {
-        returnValue[self.getOutputMapping('upper')] = upperValue;
-        returnValue[self.getOutputMapping('lower')] = lowerValue;
+        regressionValue = regressionSeries[i];
+
+        // Only points that actually have regression data count towards the standard deviation.
+        regressionWindow.push(regressionValue || NaN);
+
+        // If there is no previous regression data available, then skip.
+        if (previousRegression && regressionValue === regressionValue) {
+            regressionStandardDeviation = regressionWindow.getStandardDeviation();
+
+            // Calculate the upper and lower values.
+            upperOutput[i] = regressionValue + (regressionStandardDeviation * deviations);
+            lowerOutput[i] = regressionValue - (regressionStandardDeviation * deviations);
+        }
+
+        previousRegression = regressionValue;
     }
 
-    return returnValue;
+    return outputs;
 };
 
 module.exports = PolynomialRegressionChannel;
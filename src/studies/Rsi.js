@@ -1,4 +1,6 @@
 var Base = require('./Base');
+var kernels = require('./kernels');
+var intermediates = require('./intermediates');
 var _ = require('lodash');
 
 function Rsi(inputs, outputMap) {
@@ -16,6 +18,9 @@ function Rsi(inputs, outputMap) {
 // Create a copy of the Base "class" prototype for use in this "class."
 Rsi.prototype = Object.create(Base.prototype);
 
+// Kernel for series computation (see kernels.js). studies/index.js chooses the backend.
+Rsi.prototype.seriesKernel = kernels.js.Rsi;
+
 Rsi.prototype.calculateInitialAverageGain = function(initialDataPoint, dataSegment) {
     var previousDataPoint = initialDataPoint;
 
@@ -77,4 +82,13 @@ Rsi.prototype.tick = function() {
     return returnValue;
 };
 
+Rsi.prototype.computeSeries = function(columns) {
+    var outputs = this.createSeriesOutputs(columns.length);
+
+    this.seriesKernel(this, columns.length, columns.close, intermediates.gains(columns), intermediates.losses(columns), columns.resets,
+        outputs[this.getOutputMapping('rsi')], this.getInput('length'));
+
+    return outputs;
+};
+
 module.exports = Rsi;
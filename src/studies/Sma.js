@@ -1,5 +1,5 @@
 var Base = require('./Base');
-var _ = require('lodash');
+var RollingWindow = Base.RollingWindow;
 
 function Sma(inputs, outputMap) {
     this.constructor = Sma;
@@ -8,28 +8,62 @@ function Sma(inputs, outputMap) {
     if (!inputs.length) {
         throw 'No length input parameter provided to study.';
     }
+
+    this.closeWindow = new RollingWindow(inputs.length);
 }
 
 // Create a copy of the Base "class" prototype for use in this "class."
 Sma.prototype = Object.create(Base.prototype);
 
 Sma.prototype.tick = function() {
-    var dataSegment = this.getDataSegment(this.getInput('length'));
-    var dataSegmentLength = dataSegment.length;
-    var sma = 0.0;
+    var self = this;
+    var length = self.getInput('length');
     var returnValue = {};
 
-    if (dataSegmentLength < this.getInput('length')) {
-        return returnValue;
+    if (self.continuesPreviousTick()) {
+        self.closeWindow.push(self.getLast().close);
+    }
+    else {
+        // Start over using the most recent data.
+        self.closeWindow.reset();
+        self.getDataSegment(length).forEach(function(dataPoint) {
+            self.closeWindow.push(dataPoint.close);
+        });
     }
 
-    sma = _.reduce(dataSegment, function(memo, dataPoint) {
-        return memo + dataPoint.close;
-    }, 0) / dataSegmentLength;
+    if (self.closeWindow.getCount() < length) {
+        return returnValue;
+    }
 
-    returnValue[this.getOutputMapping('sma')] = sma;
+    returnValue[self.getOutputMapping('sma')] = self.closeWindow.getSum() / length;
 
     return returnValue;
 };
 
+Sma.prototype.computeSeries = function(columns) {
+    var outputs = this.createSeriesOutputs(columns.length);
+    var smaOutput = outputs[this.getOutputMapping('sma')];
+    var close = columns.close;
+    var resets = columns.resets;
+    var length = this.getInput('length');
+    var closeWindow = this.closeWindow;
+    var i = 0;
+
+    for (i = 0; i < columns.length; i++) {
+        if (resets[i]) {
+            closeWindow.reset();
+        }
+
+        closeWindow.push(close[i]);
+
+        if (closeWindow.getCount() < length) {
+            continue;
+        }
+
+        smaOutput[i] = closeWindow.getSum() / length;
+    }
+
+    return outputs;
+};
+
 module.exports = Sma;
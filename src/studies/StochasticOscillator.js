@@ -1,5 +1,5 @@
-var _ = require('lodash');
 var Base = require('./Base');
+var RollingWindow = Base.RollingWindow;
 
 function StochasticOscillator(inputs, outputMap) {
     this.constructor = StochasticOscillator;
@@ -8,53 +8,101 @@ function StochasticOscillator(inputs, outputMap) {
     if (!inputs.length) {
         throw 'No length input parameter provided to study.';
     }
+
+    this.lowWindow = new RollingWindow(inputs.length, {minimum: true});
+    this.highWindow = new RollingWindow(inputs.length, {maximum: true});
+    this.KWindow = new RollingWindow(inputs.averageLength);
 }
 
 // Create a copy of the Base "class" prototype for use in this "class."
 StochasticOscillator.prototype = Object.create(Base.prototype);
 
+StochasticOscillator.prototype.reset = function() {
+    this.lowWindow.reset();
+    this.highWindow.reset();
+    this.KWindow.reset();
+};
+
+// Adds a data point to the windows, returning the K and D values once enough data is available.
+StochasticOscillator.prototype.step = function(low, high, close) {
+    var averageLength = this.getInput('averageLength');
+    var highLowDifference = 0.0;
+    var K = 0.0;
+
+    this.lowWindow.push(low);
+    this.highWindow.push(high);
+
+    if (this.lowWindow.getCount() < this.getInput('length')) {
+        return null;
+    }
+
+    highLowDifference = this.highWindow.getMaximum() - this.lowWindow.getMinimum();
+    K = highLowDifference > 0 ? 100 * ((close - this.lowWindow.getMinimum()) / highLowDifference) : 0;
+
+    this.KWindow.push(K);
+
+    return {
+        K: K,
+
+        // Average the K values, using the current K value for points that do not have one.
+        D: (this.KWindow.getSum() + K * (averageLength - this.KWindow.getCount())) / averageLength
+    };
+};
+
 StochasticOscillator.prototype.tick = function() {
     var self = this;
-    var dataSegment = self.getDataSegment(self.getInput('length'));
-    var dataSegmentLength = dataSegment.length;
-    var averageLengthDataSegment = [];
     var lastDataPoint = self.getLast();
-    var low = 0.0;
-    var high = 0.0;
-    var highLowDifference = 0.0;
-    var K = 0.0;
-    var D = 0.0;
-    var KOutputName = self.getOutputMapping('K');
+    var values = null;
     var returnValue = {};
 
-    if (dataSegmentLength < self.getInput('length')) {
+    if (self.continuesPreviousTick()) {
+        values = self.step(lastDataPoint.low, lastDataPoint.high, lastDataPoint.close);
+    }
+    else {
+        // Start over using the most recent data.
+        self.reset();
+        self.getDataSegment(self.getInput('length') + self.getInput('averageLength') - 1).forEach(function(dataPoint) {
+            values = self.step(dataPoint.low, dataPoint.high, dataPoint.close);
+        });
+    }
+
+    if (!values) {
         return returnValue;
     }
 
-    averageLengthDataSegment = dataSegment.slice(dataSegmentLength - self.getInput('averageLength'), dataSegmentLength);
-
-    low = _.min(_.map(dataSegment, function(dataPoint) {
-        return dataPoint.low;
-    }));
-    high = _.max(_.map(dataSegment, function(dataPoint) {
-        return dataPoint.high;
-    }));
-    highLowDifference = high - low;
-    K = highLowDifference > 0 ? 100 * ((lastDataPoint.close - low) / highLowDifference) : 0;
-    D = _.reduce(averageLengthDataSegment, function(memo, dataPoint) {
-        if (typeof dataPoint[KOutputName] === 'number') {
-            return memo + dataPoint[KOutputName];
+    returnValue[self.getOutputMapping('K')] = values.K;
+    returnValue[self.getOutputMapping('D')] = values.D;
+
+    return returnValue;
+};
+
+StochasticOscillator.prototype.computeSeries = function(columns) {
+    var outputs = this.createSeriesOutputs(columns.length);
+    var KOutput = outputs[this.getOutputMapping('K')];
+    var DOutput = outputs[this.getOutputMapping('D')];
+    var high = columns.high;
+    var low = columns.low;
+    var close = columns.close;
+    var resets = columns.resets;
+    var values = null;
+    var i = 0;
+
+    for (i = 0; i < columns.length; i++) {
+        if (resets[i]) {
+            this.reset();
         }
-        else {
-            // Use the current K value for the last data point.
-            return memo + K;
+
+        values = this.step(low[i], high[i], close[i]);
+
+        if (!values) {
+            continue;
         }
-    }, 0) / averageLengthDataSegment.length;
 
-    returnValue[KOutputName] = K;
-    returnValue[self.getOutputMapping('D')] = D;
+        KOutput[i] = values.K;
+        DOutput[i] = values.D;
+    }
 
-    return returnValue;
+    return outputs;
 };
 
 module.exports = StochasticOscillator;
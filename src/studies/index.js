@@ -8,3 +8,19 @@ module.exports.AverageVolume = require('./AverageVolume');
 module.exports.StochasticOscillator = require('./StochasticOscillator');
 module.exports.BollingerBands = require('./BollingerBands');
 module.exports.AverageDirectionalIndex = require('./AverageDirectionalIndex');
+
+var kernels = require('./kernels');
+
+// Kernel backend for each study that has series kernels: 'native' uses the native kernel module where it
+// is installed (and JavaScript otherwise), and 'js' always uses JavaScript.
+var kernelBackends = {
+    Ema: 'native',
+    Rsi: 'native',
+    DynamicZoneRsi: 'native',
+    AverageTrueRange: 'native',
+    AverageDirectionalIndex: 'native'
+};
+
+Object.keys(kernelBackends).forEach(function(studyName) {
+    kernels.use(module.exports[studyName], kernelBackends[studyName]);
+});
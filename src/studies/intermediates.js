@@ -0,0 +1,98 @@
+// Intermediate series used by more than one study. Each is calculated once per set of columns and
+// then shared by every study run over those columns.
+
+// Returns the named series for the columns, calculating it on first use.
+module.exports.get = function(columns, name, calculate) {
+    var cache = columns.intermediates;
+
+    if (!cache) {
+        cache = columns.intermediates = {};
+    }
+    if (!cache[name]) {
+        cache[name] = calculate(columns);
+    }
+
+    return cache[name];
+};
+
+// Price increase from the previous data point (or zero).
+module.exports.gains = function(columns) {
+    return module.exports.get(columns, 'gains', function() {
+        var close = columns.close;
+        var gains = new Float64Array(columns.length);
+        var i = 0;
+
+        for (i = 1; i < columns.length; i++) {
+            gains[i] = close[i] > close[i - 1] ? close[i] - close[i - 1] : 0;
+        }
+
+        return gains;
+    });
+};
+
+// Price decrease from the previous data point (or zero).
+module.exports.losses = function(columns) {
+    return module.exports.get(columns, 'losses', function() {
+        var close = columns.close;
+        var losses = new Float64Array(columns.length);
+        var i = 0;
+
+        for (i = 1; i < columns.length; i++) {
+            losses[i] = close[i] < close[i - 1] ? close[i - 1] - close[i] : 0;
+        }
+
+        return losses;
+    });
+};
+
+module.exports.trueRange = function(columns) {
+    return module.exports.get(columns, 'trueRange', function() {
+        var high = columns.high;
+        var low = columns.low;
+        var close = columns.close;
+        var trueRange = new Float64Array(columns.length);
+        var i = 0;
+
+        if (columns.length) {
+            trueRange[0] = high[0] - low[0];
+        }
+
+        for (i = 1; i < columns.length; i++) {
+            trueRange[i] = Math.max(high[i] - low[i], Math.abs(high[i] - close[i - 1]), Math.abs(low[i] - close[i - 1]));
+        }
+
+        return trueRange;
+    });
+};
+
+// Positive directional movement (+DM).
+module.exports.plusDirectionalMovement = function(columns) {
+    return module.exports.get(columns, 'plusDirectionalMovement', function() {
+        var high = columns.high;
+        var low = columns.low;
+        var plusDirectionalMovement = new Float64Array(columns.length);
+        var i = 0;
+
+        for (i = 1; i < columns.length; i++) {
+            plusDirectionalMovement[i] = high[i] - high[i - 1] > low[i - 1] - low[i] ? Math.max(high[i] - high[i - 1], 0) : 0;
+        }
+
+        return plusDirectionalMovement;
+    });
+};
+
+// Negative directional movement (-DM).
+module.exports.minusDirectionalMovement = function(columns) {
+    return module.exports.get(columns, 'minusDirectionalMovement', function() {
+        var high = columns.high;
+        var low = columns.low;
+        var minusDirectionalMovement = new Float64Array(columns.length);
+        var i = 0;
+
+        for (i = 1; i < columns.length; i++) {
+            minusDirectionalMovement[i] = low[i - 1] - low[i] > high[i] - high[i - 1] ? Math.max(low[i - 1] - low[i], 0) : 0;
+        }
+
+        return minusDirectionalMovement;
+    });
+};
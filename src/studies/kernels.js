@@ -0,0 +1,359 @@
+// Series kernels for the studies that take the most time to compute. A kernel runs a study's calculation
+// over typed-array columns, reading the study's running values (previous EMA, average gain and loss,
+// etc.) from a state object at the start and storing them back at the end, so that one batch of data
+// continues on from the last.
+//
+// Kernels come from a backend. The JavaScript backend is always available. A native backend is used if
+// the forex-backtesting-kernels module is installed; it must export functions with the same names and
+// arguments as the JavaScript kernels below (any it does not export fall back to JavaScript), and must
+// produce the same outputs exactly. Which backend each study uses is chosen in studies/index.js.
+
+var nativeKernels = null;
+
+try {
+    nativeKernels = require('forex-backtesting-kernels');
+}
+catch (error) {
+    nativeKernels = null;
+}
+
+// Returns what +value.toFixed(2) does, without building a string for the usual case. Rounding value * 100
+// can only differ from rounding the exact product when it is within rounding error of a tie, so those
+// cases (and very large values, zeros, NaNs and infinities) use toFixed.
+function roundToHundredths(value) {
+    var scaled = value * 100;
+    var fraction = scaled - Math.floor(scaled);
+
+    if (value !== 0 && Math.abs(value) < 1e15 && Math.abs(fraction - 0.5) > 1e-7) {
+        return Math.round(scaled) / 100;
+    }
+
+    return +value.toFixed(2);
+}
+
+module.exports.js = {};
+
+module.exports.js.Ema = function(state, count, close, emaOutput, length) {
+    var K = 2 / (1 + length);
+    var previousEma = state.previousEma;
+    var ema = 0.0;
+    var i = 0;
+
+    for (i = 0; i < count; i++) {
+        if (!previousEma) {
+            // Use the last data item as the first previous EMA value.
+            previousEma = close[i];
+        }
+
+        ema = (close[i] * K) + (previousEma * (1 - K));
+
+        // Set the new EMA just calculated as the previous EMA.
+        previousEma = ema;
+
+        emaOutput[i] = ema;
+    }
+
+    state.previousEma = previousEma;
+};
+
+module.exports.js.Rsi = function(state, count, close, gains, losses, resets, rsiOutput, length) {
+    var previousAverageGain = state.previousAverageGain;
+    var previousAverageLoss = state.previousAverageLoss;
+    var segmentStart = 0;
+    var gainSum = 0.0;
+    var lossSum = 0.0;
+    var RS = 0.0;
+    var i = 0;
+    var j = 0;
+
+    for (i = 0; i < count; i++) {
+        if (resets[i]) {
+            segmentStart = i;
+        }
+        if (i - segmentStart + 1 < length) {
+            continue;
+        }
+
+        if (!previousAverageGain || !previousAverageLoss) {
+            // Average the gains and losses over the last n data points, starting (as tick() does)
+            // from the current data point.
+            j = i - length + 1;
+            gainSum = close[j] > close[i] ? close[j] - close[i] : 0;
+            lossSum = close[j] < close[i] ? close[i] - close[j] : 0;
+            for (j = j + 1; j <= i; j++) {
+                gainSum += gains[j];
+                lossSum += losses[j];
+            }
+
+            previousAverageGain = gainSum / length;
+            previousAverageLoss = lossSum / length;
+        }
+        else {
+            previousAverageGain = ((previousAverageGain * (length - 1)) + gains[i]) / length;
+            previousAverageLoss = ((previousAverageLoss * (length - 1)) + losses[i]) / length;
+        }
+
+        RS = previousAverageLoss > 0 ? previousAverageGain / previousAverageLoss : 0;
+
+        rsiOutput[i] = 100 - (100 / (1 + RS));
+    }
+
+    state.previousAverageGain = previousAverageGain;
+    state.previousAverageLoss = previousAverageLoss;
+};
+
+module.exports.js.AverageTrueRange = function(state, count, high, low, trueRange, resets, atrOutput, length) {
+    var previousAtr = state.previousAtr;
+    var segmentStart = 0;
+    var atr = 0.0;
+    var sum = 0.0;
+    var i = 0;
+    var j = 0;
+
+    for (i = 0; i < count; i++) {
+        if (resets[i]) {
+            segmentStart = i;
+        }
+        if (i - segmentStart + 1 < length) {
+            continue;
+        }
+
+        atr = 0;
+
+        if (previousAtr) {
+            // Calculate TR and ATR.
+            atr = ((previousAtr * (length - 1)) + trueRange[i]) / length;
+
+            if (state.previousTrValuesCount) {
+                state.previousTrValues = [];
+                state.previousTrValuesCount = 0;
+            }
+        }
+        else {
+            // Track the TR along with only as many previous ones as are needed.
+            state.previousTrValues.push(high[i] - low[i]);
+            if (++state.previousTrValuesCount > length) {
+                state.previousTrValues.shift();
+                state.previousTrValuesCount = length;
+            }
+
+            // Calculate the initial ATR if there are enough previous TR values.
+            if (state.previousTrValuesCount === length) {
+                sum = 0;
+                for (j = 0; j < length; j++) {
+                    sum += state.previousTrValues[j];
+                }
+                atr = sum / length;
+            }
+        }
+
+        previousAtr = atr;
+
+        if (atr) {
+            atrOutput[i] = atr;
+        }
+    }
+
+    state.previousAtr = previousAtr;
+};
+
+// The averages are initialized from the sums of every past TR, +DM, -DM and DX value, which the state keeps
+// as running totals (as tick() does).
+module.exports.js.AverageDirectionalIndex = function(state, count, trueRange, plusDirectionalMovement, minusDirectionalMovement, resets, pDIOutput, mDIOutput, ADXOutput, length) {
+    var pastValues = state.pastValues;
+    var tickIndex = state.tickIndex;
+    var TRTotal = pastValues.TRTotal;
+    var pDMTotal = pastValues.pDMTotal;
+    var mDMTotal = pastValues.mDMTotal;
+    var DXTotal = pastValues.DXTotal;
+    var TR2 = pastValues.TR2;
+    var pDM2 = pastValues.pDM2;
+    var mDM2 = pastValues.mDM2;
+    var previousADX = pastValues.ADX;
+    var TR = 0.0;
+    var pDM = 0.0;
+    var mDM = 0.0;
+    var pDI = 0.0;
+    var mDI = 0.0;
+    var DX = 0.0;
+    var ADX = 0.0;
+    var i = 0;
+
+    for (i = 0; i < count; i++) {
+        if (resets[i]) {
+            tickIndex = 0;
+        }
+
+        tickIndex++;
+
+        if (tickIndex < 2) {
+            continue;
+        }
+
+        pDI = 0;
+        mDI = 0;
+        ADX = 0;
+
+        TR = trueRange[i];
+        pDM = plusDirectionalMovement[i];
+        mDM = minusDirectionalMovement[i];
+
+        TRTotal += TR;
+        pDMTotal += pDM;
+        mDMTotal += mDM;
+
+        if (tickIndex > length) {
+            if (tickIndex === length + 1) {
+                TR2 = TRTotal;
+                pDM2 = pDMTotal;
+                mDM2 = mDMTotal;
+            }
+            else {
+                TR2 = TR2 - (TR2 / length) + TR;
+                pDM2 = pDM2 - (pDM2 / length) + pDM;
+                mDM2 = mDM2 - (mDM2 / length) + mDM;
+            }
+
+            pDI = 100 * (pDM2 / TR2);
+            mDI = 100 * (mDM2 / TR2);
+            DX = 100 * (Math.abs(pDI - mDI) / (pDI + mDI));
+
+            DXTotal += DX;
+        }
+
+        if (tickIndex >= length * 2) {
+            if (tickIndex === length * 2) {
+                ADX = DXTotal / length;
+            }
+            else {
+                ADX = ((previousADX * (length - 1)) + DX) / length;
+            }
+
+            previousADX = ADX;
+        }
+
+        pDIOutput[i] = roundToHundredths(pDI);
+        mDIOutput[i] = roundToHundredths(mDI);
+        ADXOutput[i] = roundToHundredths(ADX);
+    }
+
+    state.tickIndex = tickIndex;
+    pastValues.TRTotal = TRTotal;
+    pastValues.pDMTotal = pDMTotal;
+    pastValues.mDMTotal = mDMTotal;
+    pastValues.DXTotal = DXTotal;
+    pastValues.TR2 = TR2;
+    pastValues.pDM2 = pDM2;
+    pastValues.mDM2 = mDM2;
+    pastValues.ADX = previousADX;
+};
+
+// The standard deviation is taken over every moving average calculated so far, from running sums kept in
+// the state (as tick() does).
+module.exports.js.DynamicZoneRsi = function(state, count, close, gains, losses, resets, rsiOutput, upperOutput, lowerOutput, length, bandsLength, deviations) {
+    var previousAverageGain = state.previousAverageGain;
+    var previousAverageLoss = state.previousAverageLoss;
+    var previousRsiValues = state.previousRsiValues;
+    var movingAverageSum = state.movingAverageSum;
+    var movingAverageSquaredSum = state.movingAverageSquaredSum;
+    var movingAverageCount = state.movingAverageCount;
+    var segmentStart = 0;
+    var gainSum = 0.0;
+    var lossSum = 0.0;
+    var RS = 0.0;
+    var rsi = 0.0;
+    var rsiSum = 0.0;
+    var rsiMovingAverage = 0.0;
+    var mean = 0.0;
+    var rsiMovingAverageStandardDeviation = 0.0;
+    var i = 0;
+    var j = 0;
+
+    for (i = 0; i < count; i++) {
+        if (resets[i]) {
+            segmentStart = i;
+        }
+        if (i - segmentStart + 1 < length) {
+            continue;
+        }
+
+        // Calculate the normal RSI.
+        if (!previousAverageGain || !previousAverageLoss) {
+            j = i - length + 1;
+            gainSum = close[j] > close[i] ? close[j] - close[i] : 0;
+            lossSum = close[j] < close[i] ? close[i] - close[j] : 0;
+            for (j = j + 1; j <= i; j++) {
+                gainSum += gains[j];
+                lossSum += losses[j];
+            }
+
+            previousAverageGain = gainSum / length;
+            previousAverageLoss = lossSum / length;
+        }
+        else {
+            previousAverageGain = ((previousAverageGain * (length - 1)) + gains[i]) / length;
+            previousAverageLoss = ((previousAverageLoss * (length - 1)) + losses[i]) / length;
+        }
+
+        RS = previousAverageLoss > 0 ? previousAverageGain / previousAverageLoss : 0;
+        rsi = 100 - (100 / (1 + RS));
+        rsiOutput[i] = rsi;
+
+        // Track only the necessary number of previous RSI values.
+        previousRsiValues.push(rsi);
+        if (previousRsiValues.length > bandsLength) {
+            previousRsiValues.shift();
+        }
+        if (previousRsiValues.length < bandsLength) {
+            continue;
+        }
+
+        // Calculate a moving average of the RSI.
+        rsiSum = 0;
+        for (j = 0; j < bandsLength; j++) {
+            rsiSum += previousRsiValues[j];
+        }
+        rsiMovingAverage = rsiSum / bandsLength;
+
+        // Calculate the standard deviation of the moving average.
+        movingAverageSum += rsiMovingAverage;
+        movingAverageSquaredSum += rsiMovingAverage * rsiMovingAverage;
+        movingAverageCount++;
+        mean = movingAverageSum / movingAverageCount;
+        rsiMovingAverageStandardDeviation = Math.sqrt(movingAverageSquaredSum / movingAverageCount - mean * mean);
+
+        // Calculate the upper and lower bands using the deviation factor.
+        upperOutput[i] = rsiMovingAverage + (deviations * rsiMovingAverageStandardDeviation);
+        lowerOutput[i] = rsiMovingAverage - (deviations * rsiMovingAverageStandardDeviation);
+    }
+
+    state.previousAverageGain = previousAverageGain;
+    state.previousAverageLoss = previousAverageLoss;
+    state.movingAverageSum = movingAverageSum;
+    state.movingAverageSquaredSum = movingAverageSquaredSum;
+    state.movingAverageCount = movingAverageCount;
+};
+
+module.exports.native = nativeKernels || {};
+
+// Returns the names of the backends that can be used.
+module.exports.getBackendNames = function() {
+    return nativeKernels ? ['js', 'native'] : ['js'];
+};
+
+// Returns the kernel for a study from the given backend, falling back to the JavaScript kernel if the
+// backend is not available or has no kernel for the study.
+module.exports.get = function(studyName, backendName) {
+    var backend = module.exports[backendName];
+
+    if (backendName !== 'js' && backendName !== 'native') {
+        throw 'Invalid kernel backend ' + backendName;
+    }
+
+    return (backend && backend[studyName]) || module.exports.js[studyName];
+};
+
+// Makes a study class use its kernel from the given backend.
+module.exports.use = function(study, backendName) {
+    study.prototype.seriesKernel = module.exports.get(study.name, backendName);
+};
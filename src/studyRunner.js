@@ -0,0 +1,147 @@
+var timeframes = require('./timeframes');
+
+// Fields every data point has prior to any studies being run.
+var priceFields = ['timestamp', 'volume', 'open', 'high', 'low', 'close'];
+
+// Marks each data point at which the cumulative data used by studies starts over, which is wherever
+// there is a significant gap.
+module.exports.buildResets = function(timestamps, gapThreshold) {
+    var resets = new Uint8Array(timestamps.length);
+    var i = 0;
+
+    for (i = 0; i < timestamps.length; i++) {
+        resets[i] = i === 0 || timestamps[i] - timestamps[i - 1] > gapThreshold ? 1 : 0;
+    }
+
+    return resets;
+};
+
+// Runs a study one tick at a time over series columns, for studies that have no series computation.
+module.exports.tickSeries = function(study, columns) {
+    var outputs = study.createSeriesOutputs(columns.length);
+    var studyOutputs = study.getOutputMappings();
+    var cumulativeData = [];
+    var dataPoint;
+    var studyTickValues;
+    var studyProperty = '';
+    var outputName = '';
+    var i = 0;
+    var j = 0;
+
+    for (i = 0; i < columns.length; i++) {
+        if (columns.resets[i]) {
+            cumulativeData = [];
+        }
+
+        dataPoint = {};
+        for (j = 0; j < priceFields.length; j++) {
+            dataPoint[priceFields[j]] = columns[priceFields[j]][i];
+        }
+        cumulativeData.push(dataPoint);
+
+        study.setData(cumulativeData);
+        studyTickValues = study.tick();
+
+        // Augment the data point with the data the study generates, since studies may refer to their previous values.
+        for (studyProperty in studyOutputs) {
+            outputName = studyOutputs[studyProperty];
+
+            if (studyTickValues && typeof studyTickValues[outputName] === 'number') {
+                dataPoint[outputName] = studyTickValues[outputName];
+                outputs[outputName][i] = studyTickValues[outputName];
+            }
+            else {
+                dataPoint[outputName] = '';
+            }
+        }
+
+        // Periodically free up memory.
+        if (cumulativeData.length >= 2000) {
+            cumulativeData.splice(0, 1000);
+        }
+    }
+
+    return outputs;
+};
+
+// Returns a key identifying a study, its inputs and its timeframe (if not the prepared data's), independent
+// of the order of the inputs.
+module.exports.getStudyKey = function(studyDefinition) {
+    var inputs = studyDefinition.inputs;
+    var sortedInputs = {};
+    var timeframe = timeframes.getTimeframe(studyDefinition);
+
+    Object.keys(inputs).sort().forEach(function(inputName) {
+        sortedInputs[inputName] = inputs[inputName];
+    });
+
+    return studyDefinition.study.name + JSON.stringify(sortedInputs) + (timeframe > 1 ? '@' + timeframe + 'm' : '');
+};
+
+// Builds the graph of studies to compute for a list of study definitions. Definitions with the same
+// study and inputs share a single study instance, whose outputs are fanned out to each output map.
+module.exports.buildGraph = function(studyDefinitions) {
+    var nodes = [];
+    var nodesByKey = {};
+
+    studyDefinitions.forEach(function(studyDefinition) {
+        var key = module.exports.getStudyKey(studyDefinition);
+
+        if (!nodesByKey[key]) {
+            nodesByKey[key] = {
+                key: key,
+                study: new studyDefinition.study(studyDefinition.inputs, studyDefinition.outputMap),
+                outputMaps: []
+            };
+            nodes.push(nodesByKey[key]);
+        }
+
+        nodesByKey[key].outputMaps.push(studyDefinition.outputMap);
+    });
+
+    return nodes;
+};
+
+// Computes each study in a graph over the columns. Intermediate series shared by studies (price changes,
+// true range, regression fits, etc.) are calculated once and kept with the columns.
+module.exports.run = function(nodes, columns, progress) {
+    var allOutputs = {};
+    var nodeCount = nodes.length;
+
+    nodes.forEach(function(node, index) {
+        var study = node.study;
+        var outputs = study.computeSeries(columns) || module.exports.tickSeries(study, columns);
+
+        node.outputMaps.forEach(function(outputMap) {
+            var outputKey = '';
+
+            for (outputKey in outputMap) {
+                allOutputs[outputMap[outputKey]] = outputs[study.getOutputMapping(outputKey)];
+            }
+        });
+
+        if (progress) {
+            progress(index + 1, nodeCount);
+        }
+    });
+
+    delete columns.intermediates;
+
+    return allOutputs;
+};
+
+// Augments data points with series outputs, using empty strings for missing values.
+module.exports.annotate = function(data, outputs) {
+    var dataPointCount = data.length;
+    var outputName = '';
+    var values;
+    var i = 0;
+
+    for (outputName in outputs) {
+        values = outputs[outputName];
+
+        for (i = 0; i < dataPointCount; i++) {
+            data[i][outputName] = values[i] === values[i] ? values[i] : '';
+        }
+    }
+};
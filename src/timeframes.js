@@ -0,0 +1,233 @@
+var ColumnStore = require('./ColumnStore');
+
+// Higher timeframes are built from the one-minute bars in prepared data. Each higher timeframe bar covers
+// the minutes from its timestamp up to the next multiple of the timeframe, and is complete once its last
+// minute has closed, or once a later bar shows up if its last minute is missing. Studies computed on a
+// higher timeframe are aligned back onto the one-minute bars using only bars complete at each minute, so
+// strategies never see a bar before it has closed.
+
+// Length in milliseconds of the bars in prepared data.
+var baseBarLength = 60 * 1000;
+
+// Columns kept for each higher timeframe bar besides its prices: the index of the first one-minute bar it
+// covers, and the index of the one-minute bar at which it is complete.
+var indexColumns = ['firstIndex', 'completedIndex'];
+
+module.exports.baseBarLength = baseBarLength;
+module.exports.indexColumns = indexColumns;
+
+// Returns the timeframe (in minutes) of a study definition. Definitions without one use the prepared data
+// as is.
+module.exports.getTimeframe = function(studyDefinition) {
+    var timeframe = studyDefinition.timeframe;
+
+    if (timeframe === undefined) {
+        return 1;
+    }
+
+    if (timeframe !== Math.floor(timeframe) || timeframe < 1) {
+        throw 'Invalid timeframe ' + timeframe + ' provided for study.';
+    }
+
+    return timeframe;
+};
+
+module.exports.getLength = function(timeframe) {
+    return timeframe * baseBarLength;
+};
+
+// Returns the gap after which studies on a timeframe start over, allowing for the same slack over the
+// usual spacing of bars as the one-minute gap threshold does.
+module.exports.getGapThreshold = function(gapThreshold, timeframe) {
+    return gapThreshold - baseBarLength + module.exports.getLength(timeframe);
+};
+
+// Builds the bars for a timeframe from a complete store of one-minute bars, writing them to another store.
+module.exports.resample = function(store, timeframeStore, timeframe) {
+    var timeframeLength = module.exports.getLength(timeframe);
+    var columnNames = ColumnStore.baseColumns.concat(indexColumns);
+    var bars = {};
+    var barCount = 0;
+    var current = null;
+    var lastBarStart = NaN;
+    var count = store.getCount();
+    var columns = null;
+    var timestamps = null;
+    var barStart = 0;
+    var index = 0;
+    var start = 0;
+    var i = 0;
+
+    timeframeStore.create(columnNames);
+
+    // Each chunk of one-minute bars completes at most one bar more than it has minutes.
+    columnNames.forEach(function(columnName) {
+        bars[columnName] = new Float64Array(ColumnStore.chunkSize + 1);
+    });
+
+    function addBar(completedIndex) {
+        bars.timestamp[barCount] = current.timestamp;
+        bars.volume[barCount] = current.volume;
+        bars.open[barCount] = current.open;
+        bars.high[barCount] = current.high;
+        bars.low[barCount] = current.low;
+        bars.close[barCount] = current.close;
+        bars.firstIndex[barCount] = current.firstIndex;
+        bars.completedIndex[barCount] = completedIndex;
+        barCount++;
+
+        lastBarStart = current.timestamp;
+        current = null;
+    }
+
+    function writeBars() {
+        var columns = {};
+
+        columnNames.forEach(function(columnName) {
+            columns[columnName] = bars[columnName].subarray(0, barCount);
+        });
+
+        timeframeStore.append(columns);
+        barCount = 0;
+    }
+
+    for (start = 0; start < count; start += ColumnStore.chunkSize) {
+        columns = store.readColumns(ColumnStore.baseColumns, start, ColumnStore.chunkSize);
+        timestamps = columns.timestamp;
+
+        for (i = 0; i < timestamps.length; i++) {
+            index = start + i;
+            barStart = Math.floor(timestamps[i] / timeframeLength) * timeframeLength;
+
+            // A minute in a later bar means the current bar is complete, even if its last minute is missing.
+            if (current && barStart !== current.timestamp) {
+                addBar(index);
+            }
+
+            // Skip anything more for a bar that is already complete.
+            if (!current && barStart === lastBarStart) {
+                continue;
+            }
+
+            if (!current) {
+                current = {
+                    timestamp: barStart,
+                    volume: 0,
+                    open: columns.open[i],
+                    high: columns.high[i],
+                    low: columns.low[i],
+                    close: columns.close[i],
+                    firstIndex: index
+                };
+            }
+
+            current.volume += columns.volume[i];
+            current.high = Math.max(current.high, columns.high[i]);
+            current.low = Math.min(current.low, columns.low[i]);
+            current.close = columns.close[i];
+
+            if (timestamps[i] + baseBarLength >= barStart + timeframeLength) {
+                addBar(index);
+            }
+        }
+
+        writeBars();
+    }
+
+    // The last bar is kept (so that studies start over for it after a gap) but is never complete.
+    if (current) {
+        addBar(count);
+        writeBars();
+    }
+
+    timeframeStore.markComplete();
+};
+
+// Aligns study output columns from a timeframe's store onto count one-minute bars, calling
+// sink(columns) with each chunk of aligned values in order. Each minute gets the values of the last bar
+// complete at that minute, or NaN once a bar after a gap has started (as studies start over there).
+module.exports.align = function(timeframeStore, columnNames, gapThreshold, count, sink) {
+    var readColumnNames = ['timestamp'].concat(indexColumns, columnNames);
+    var barCount = timeframeStore.getCount();
+    var bars = null;
+    var barStart = 0;
+    var barIndex = 0;
+    var previousTimestamp = NaN;
+    var resetPending = true;
+    var values = new Float64Array(columnNames.length);
+    var columns = null;
+    var chunkCount = 0;
+    var index = 0;
+    var offset = 0;
+    var start = 0;
+    var i = 0;
+    var j = 0;
+
+    for (i = 0; i < values.length; i++) {
+        values[i] = NaN;
+    }
+
+    // Returns the bar at barIndex, reading the next chunk of bars as needed, or false if there are no more.
+    function loadBar() {
+        if (barIndex >= barCount) {
+            return false;
+        }
+
+        if (!bars || barIndex - barStart >= bars.timestamp.length) {
+            barStart = barIndex;
+            bars = timeframeStore.readColumns(readColumnNames, barStart, ColumnStore.chunkSize);
+        }
+
+        return true;
+    }
+
+    for (start = 0; start < count; start += ColumnStore.chunkSize) {
+        chunkCount = Math.min(ColumnStore.chunkSize, count - start);
+        columns = {};
+
+        columnNames.forEach(function(columnName) {
+            columns[columnName] = new Float64Array(chunkCount);
+        });
+
+        for (i = 0; i < chunkCount; i++) {
+            index = start + i;
+
+            // Apply every bar start and completion up to this minute, in order.
+            while (loadBar()) {
+                offset = barIndex - barStart;
+
+                if (resetPending) {
+                    if (bars.firstIndex[offset] > index) {
+                        break;
+                    }
+
+                    if (previousTimestamp !== previousTimestamp || bars.timestamp[offset] - previousTimestamp > gapThreshold) {
+                        for (j = 0; j < values.length; j++) {
+                            values[j] = NaN;
+                        }
+                    }
+
+                    previousTimestamp = bars.timestamp[offset];
+                    resetPending = false;
+                }
+
+                if (bars.completedIndex[offset] > index) {
+                    break;
+                }
+
+                for (j = 0; j < values.length; j++) {
+                    values[j] = bars[columnNames[j]][offset];
+                }
+
+                barIndex++;
+                resetPending = true;
+            }
+
+            for (j = 0; j < values.length; j++) {
+                columns[columnNames[j]][i] = values[j];
+            }
+        }
+
+        sink(columns);
+    }
+};
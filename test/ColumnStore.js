@@ -0,0 +1,102 @@
+var assert = require('assert');
+var fs = require('fs');
+var ColumnStore = require('../src/ColumnStore');
+var directories = require('./support/directories');
+
+// Creates a complete store of count data points, with each base column's values offset from the index.
+function createStore(directory, count) {
+    var store = new ColumnStore(directory);
+    var columns = {};
+
+    ColumnStore.baseColumns.forEach(function(columnName, columnIndex) {
+        var values = new Float64Array(count);
+        var i = 0;
+
+        for (i = 0; i < count; i++) {
+            values[i] = columnIndex * 1000 + i + 0.25;
+        }
+
+        columns[columnName] = values;
+    });
+
+    store.create(ColumnStore.baseColumns);
+    store.append(columns);
+    store.markComplete();
+
+    return store;
+}
+
+function withStore(count, fn) {
+    var directory = directories.create('store');
+    var store = createStore(directory, count);
+
+    try {
+        fn(store);
+    }
+    finally {
+        store.close();
+        directories.remove(directory);
+    }
+}
+
+module.exports['reads back appended values, stopping at the end of the data'] = function() {
+    withStore(25, function(store) {
+        var values = store.readColumn('close', 20, 10);
+        var i = 0;
+
+        assert.strictEqual(store.getCount(), 25);
+        assert.strictEqual(values.length, 5);
+
+        for (i = 0; i < values.length; i++) {
+            assert.strictEqual(values[i], 5000 + 20 + i + 0.25);
+        }
+
+        assert.strictEqual(store.readColumn('close', 30, 10).length, 0);
+    });
+};
+
+module.exports['rejects a column file shorter than the manifest says'] = function() {
+    withStore(25, function(store) {
+        fs.truncateSync(store.getColumnPath('high'), 24 * 8);
+
+        assert.strictEqual(store.readColumn('high', 0, 24).length, 24);
+        assert.throws(function() {
+            store.readColumn('high', 0, 25);
+        }, /fewer values/);
+    });
+};
+
+module.exports['only adds columns once they are committed with a value per data point'] = function() {
+    withStore(25, function(store) {
+        store.beginColumns(['average']);
+        store.appendColumns({average: new Float64Array(20)});
+
+        assert.strictEqual(store.hasColumn('average'), false);
+        assert.throws(function() {
+            store.commitColumns({average: 'Sma{"length":3}'});
+        }, /Invalid number of values/);
+        assert.strictEqual(store.hasColumn('average'), false);
+
+        store.appendColumns({average: new Float64Array([1, 2, 3, 4, 5])});
+        store.commitColumns({average: 'Sma{"length":3}'});
+
+        assert.strictEqual(store.hasColumn('average'), true);
+        assert.strictEqual(store.getStudyKey('average'), 'Sma{"length":3}');
+        assert.strictEqual(fs.existsSync(store.getPendingColumnPath('average')), false);
+        assert.deepEqual(Array.prototype.slice.call(store.readColumn('average', 20, 5)), [1, 2, 3, 4, 5]);
+
+        // The manifest on disk records the committed column too.
+        assert.strictEqual(new ColumnStore(store.getDirectory()).hasColumn('average'), true);
+    });
+};
+
+module.exports['replaces existing columns when they are committed again'] = function() {
+    withStore(3, function(store) {
+        store.writeColumns({average: new Float64Array([1, 2, 3])}, {average: 'Sma{"length":3}'});
+        assert.strictEqual(store.readColumn('average', 0, 3)[2], 3);
+
+        store.writeColumns({average: new Float64Array([4, 5, 6])});
+        assert.strictEqual(store.readColumn('average', 0, 3)[2], 6);
+        assert.strictEqual(store.getStudyKey('average'), undefined);
+    });
+};
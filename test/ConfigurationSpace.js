@@ -0,0 +1,65 @@
+var assert = require('assert');
+var ConfigurationSpace = require('../src/ConfigurationSpace');
+
+function createSpace() {
+    return new ConfigurationSpace({
+        ema200: [true, false],
+        rsi: [null, {rsi: 'rsi2', overbought: 95, oversold: 5}, {rsi: 'rsi2', overbought: 80, oversold: 20}],
+        length: [1, 2, 3]
+    });
+}
+
+module.exports['decodes indexes with the last option varying fastest'] = function() {
+    var space = createSpace();
+
+    assert.strictEqual(space.getCount(), 18);
+    assert.deepEqual(space.get(0), {ema200: true, rsi: null, length: 1});
+    assert.deepEqual(space.get(1), {ema200: true, rsi: null, length: 2});
+    assert.deepEqual(space.get(3), {ema200: true, rsi: {rsi: 'rsi2', overbought: 95, oversold: 5}, length: 1});
+    assert.deepEqual(space.get(17), {ema200: false, rsi: {rsi: 'rsi2', overbought: 80, oversold: 20}, length: 3});
+};
+
+module.exports['finds the index of every configuration, whatever the order of its properties'] = function() {
+    var space = createSpace();
+    var configuration = null;
+    var index = 0;
+
+    for (index = 0; index < space.getCount(); index++) {
+        // Configurations saved to the database come back with their own copies of nested values.
+        configuration = JSON.parse(JSON.stringify(space.get(index)));
+
+        assert.strictEqual(space.indexOf(configuration), index);
+    }
+
+    assert.strictEqual(space.indexOf({length: 2, rsi: {oversold: 20, overbought: 80, rsi: 'rsi2'}, ema200: false}), 16);
+};
+
+module.exports['does not find configurations outside the space'] = function() {
+    var space = createSpace();
+
+    assert.strictEqual(space.indexOf({ema200: true, rsi: null, length: 4}), -1);
+    assert.strictEqual(space.indexOf({ema200: true, rsi: {rsi: 'rsi2', overbought: 90, oversold: 10}, length: 1}), -1);
+    assert.strictEqual(space.indexOf({ema200: true, length: 1}), -1);
+    assert.strictEqual(space.indexOf({ema200: true, rsi: null, length: 1, ema100: true}), -1);
+};
+
+module.exports['builds ranges around excluded indexes'] = function() {
+    var space = createSpace();
+
+    assert.deepEqual(space.getRangesExcluding([]), [[0, 18]]);
+    assert.deepEqual(space.getRangesExcluding([5, 0, 6, 17, 6]), [[1, 5], [7, 17]]);
+    assert.deepEqual(space.getRangesExcluding([3, 4, 5, 2, 1, 0, 17, 16]), [[6, 16]]);
+    assert.strictEqual(ConfigurationSpace.countRanges(space.getRangesExcluding([2, 9, 9, 11])), 15);
+};
+
+module.exports['visits each configuration in ranges in order'] = function() {
+    var space = createSpace();
+    var indexes = [];
+
+    space.forEachInRanges([[2, 4], [10, 11]], function(configuration, index) {
+        assert.deepEqual(configuration, space.get(index));
+        indexes.push(index);
+    });
+
+    assert.deepEqual(indexes, [2, 3, 10]);
+};
@@ -0,0 +1,158 @@
+var assert = require('assert');
+var _ = require('lodash');
+var studyRunner = require('../src/studyRunner');
+var benchmarks = require('../src/benchmarks');
+var optimizers = require('../src/optimizers');
+var strategyFns = require('../src/strategies');
+var OptimizationBase = require('../src/strategies/optimization/Base');
+var SignalMatrix = require('../src/SignalMatrix');
+var WriteBuffer = require('../src/WriteBuffer');
+
+var barCount = 30000;
+var blockSize = 5000;
+var investment = 1000;
+var profitability = 0.7;
+
+// A collection that, like one in MongoDB, rejects documents with IDs it already has. Inserts complete
+// immediately.
+function createCollection() {
+    var documents = {};
+    var collection = {
+        name: 'positions',
+        insertedCount: 0,
+        duplicateCount: 0,
+        insertMany: function(insertDocuments, options, callback) {
+            var writeErrors = [];
+
+            insertDocuments.forEach(function(document, index) {
+                if (documents[document._id]) {
+                    writeErrors.push({index: index, code: 11000});
+                    return;
+                }
+
+                documents[document._id] = document;
+                collection.insertedCount++;
+            });
+
+            collection.duplicateCount += writeErrors.length;
+            callback(writeErrors.length ? {code: 11000, writeErrors: writeErrors} : null);
+        },
+        getIds: function() {
+            return Object.keys(documents).sort();
+        }
+    };
+
+    return collection;
+}
+
+// Prepares the columns the Reversals strategy needs, and a sample of its configurations.
+function prepare() {
+    var optimizer = new optimizers.Reversals('TEST');
+    var columns = benchmarks.generateColumns(barCount, 1);
+    var configurationCount = optimizer.configurationSpace.getCount();
+    var outputs = null;
+
+    columns.resets = studyRunner.buildResets(columns.timestamp, 65 * 1000);
+    outputs = studyRunner.run(studyRunner.buildGraph(optimizer.studyDefinitions), columns);
+
+    return {
+        strategyFn: strategyFns.optimization[optimizer.strategyName],
+        columns: _.extend({}, _.omit(columns, 'length', 'resets', 'intermediates'), outputs),
+        configurations: [0, 1, 2, 3].map(function(index) {
+            return optimizer.configurationSpace.get(Math.floor(index * configurationCount / 4));
+        })
+    };
+}
+
+// Backtests strategies from the block at start up to (not including) the block at end, saving closed
+// positions after each block as workers do.
+function backtestBlocks(fixture, strategies, start, end) {
+    var blockStart = 0;
+
+    for (blockStart = start; blockStart < end; blockStart += blockSize) {
+        strategies.forEach(function(strategy) {
+            var blockColumns = {};
+
+            strategy.getColumnNames().forEach(function(columnName) {
+                blockColumns[columnName] = fixture.columns[columnName].subarray(blockStart, blockStart + blockSize);
+            });
+
+            strategy.backtestBlock(new SignalMatrix(blockColumns, blockSize), investment, profitability);
+        });
+
+        fixture.strategyFn.saveExpiredPositionsPool(function() {});
+    }
+
+    fixture.strategyFn.flushPositions(function() {});
+}
+
+function withPositionWriter(collection, fn) {
+    var positionWriter = OptimizationBase.positionWriter;
+
+    OptimizationBase.positionWriter = new WriteBuffer(collection);
+    OptimizationBase.resetLedger();
+
+    try {
+        fn();
+    }
+    finally {
+        OptimizationBase.positionWriter = positionWriter;
+        OptimizationBase.resetLedger();
+    }
+}
+
+module.exports['are saved once when a run is resumed from a checkpoint'] = function() {
+    var fixture = prepare();
+    var checkpointIndex = 2 * blockSize;
+    var uninterrupted = createCollection();
+    var resumed = createCollection();
+    var uuids = [];
+    var states = null;
+
+    withPositionWriter(uninterrupted, function() {
+        var strategies = fixture.configurations.map(function(configuration) {
+            return new fixture.strategyFn('TEST', configuration, barCount);
+        });
+
+        uuids = strategies.map(function(strategy) {
+            return strategy.getUuid();
+        });
+
+        backtestBlocks(fixture, strategies, 0, barCount);
+    });
+
+    withPositionWriter(resumed, function() {
+        var strategies = fixture.configurations.map(function(configuration, index) {
+            var strategy = new fixture.strategyFn('TEST', configuration, barCount);
+
+            strategy.setUuid(uuids[index]);
+
+            return strategy;
+        });
+
+        // Checkpoint part way through, then keep going, saving positions (including ones open at the
+        // checkpoint) before being interrupted.
+        backtestBlocks(fixture, strategies, 0, checkpointIndex);
+        states = JSON.parse(JSON.stringify(strategies.map(function(strategy) {
+            return strategy.getState();
+        })));
+        backtestBlocks(fixture, strategies, checkpointIndex, checkpointIndex + 2 * blockSize);
+    });
+
+    withPositionWriter(resumed, function() {
+        var strategies = fixture.configurations.map(function(configuration, index) {
+            var strategy = new fixture.strategyFn('TEST', configuration, barCount);
+
+            strategy.setState(states[index]);
+
+            return strategy;
+        });
+
+        backtestBlocks(fixture, strategies, checkpointIndex, barCount);
+    });
+
+    assert.ok(uninterrupted.insertedCount > 0, 'No positions were saved.');
+    assert.ok(resumed.duplicateCount > 0, 'No positions were saved again after resuming.');
+    assert.strictEqual(resumed.insertedCount, uninterrupted.insertedCount);
+    assert.deepEqual(resumed.getIds(), uninterrupted.getIds());
+};
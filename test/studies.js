@@ -0,0 +1,22 @@
+var assert = require('assert');
+var studyRunner = require('../src/studyRunner');
+var benchmarks = require('../src/benchmarks');
+
+// Synthetic minute bars spanning two weekends, so that studies start over after gaps.
+var barCount = 20000;
+var seed = 1;
+
+module.exports['compute series exactly as ticking does, with every kernel backend'] = function() {
+    var columns = benchmarks.generateColumns(barCount, seed);
+    var failures = [];
+
+    columns.resets = studyRunner.buildResets(columns.timestamp, 65 * 1000);
+
+    benchmarks.checkStudies(columns).forEach(function(result) {
+        if (result.mismatches) {
+            failures.push(result.study + ' (' + result.backend + ' against ' + result.reference + ') differs at ' + result.mismatches + ' values, by up to ' + result.maximumDifference);
+        }
+    });
+
+    assert.ok(!failures.length, failures.join('; '));
+};
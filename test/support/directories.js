@@ -0,0 +1,32 @@
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+
+var createdCount = 0;
+
+// Returns a new temporary directory path for a test (the directory itself is created by whatever uses it).
+module.exports.create = function(name) {
+    createdCount++;
+
+    return path.join(os.tmpdir(), 'forex-backtesting-test-' + process.pid + '-' + createdCount + '-' + name);
+};
+
+// Removes a directory and everything in it, if it exists.
+module.exports.remove = function(directory) {
+    if (!fs.existsSync(directory)) {
+        return;
+    }
+
+    fs.readdirSync(directory).forEach(function(fileName) {
+        var filePath = path.join(directory, fileName);
+
+        if (fs.statSync(filePath).isDirectory()) {
+            module.exports.remove(filePath);
+        }
+        else {
+            fs.unlinkSync(filePath);
+        }
+    });
+
+    fs.rmdirSync(directory);
+};
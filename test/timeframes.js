@@ -0,0 +1,116 @@
+var assert = require('assert');
+var ColumnStore = require('../src/ColumnStore');
+var timeframes = require('../src/timeframes');
+var directories = require('./support/directories');
+
+var minuteLength = timeframes.baseBarLength;
+
+// Minutes (from a multiple of five minutes) with one-minute bars: a complete five-minute bar, one missing
+// its last minute, one cut short by a 48 minute gap, a complete bar after the gap, and the start of another.
+var minutes = [0, 1, 2, 3, 4, 5, 6, 7, 8, 10, 11, 60, 61, 62, 63, 64, 65];
+
+// Default gap threshold for one-minute bars, as used by optimizers.
+var gapThreshold = 65 * 1000;
+
+function createColumns(count) {
+    var columns = {};
+    var i = 0;
+
+    ColumnStore.baseColumns.forEach(function(columnName) {
+        columns[columnName] = new Float64Array(count);
+    });
+
+    for (i = 0; i < count; i++) {
+        columns.timestamp[i] = 1000 * 5 * minuteLength + minutes[i] * minuteLength;
+        columns.volume[i] = 1 + i;
+        columns.close[i] = 100 + i;
+        columns.open[i] = columns.close[i] - 0.5;
+        columns.high[i] = columns.close[i] + 1;
+        columns.low[i] = columns.close[i] - 1;
+    }
+
+    return columns;
+}
+
+// Resamples the first count minutes into five-minute bars and aligns the bars' closes back onto the minutes,
+// calling fn(timeframeStore, alignedCloses).
+function withFiveMinuteBars(count, fn) {
+    var directory = directories.create('timeframes');
+    var store = new ColumnStore(directory + '/1');
+    var timeframeStore = new ColumnStore(directory + '/5');
+    var alignedCloses = [];
+
+    try {
+        store.create(ColumnStore.baseColumns);
+        store.append(createColumns(count));
+        store.markComplete();
+
+        timeframes.resample(store, timeframeStore, 5);
+        timeframes.align(timeframeStore, ['close'], timeframes.getGapThreshold(gapThreshold, 5), count, function(columns) {
+            Array.prototype.push.apply(alignedCloses, Array.prototype.slice.call(columns.close));
+        });
+
+        fn(timeframeStore, alignedCloses);
+    }
+    finally {
+        store.close();
+        timeframeStore.close();
+        directories.remove(directory);
+    }
+}
+
+function assertValuesEqual(actual, expected) {
+    assert.strictEqual(actual.length, expected.length);
+
+    expected.forEach(function(value, index) {
+        if (value !== value) {
+            assert.ok(actual[index] !== actual[index], 'Expected NaN at ' + index + ' but got ' + actual[index]);
+        }
+        else {
+            assert.strictEqual(actual[index], value, 'Expected ' + value + ' at ' + index + ' but got ' + actual[index]);
+        }
+    });
+}
+
+module.exports['resamples minutes into bars, completing bars missing their last minute at the next bar'] = function() {
+    withFiveMinuteBars(minutes.length, function(timeframeStore) {
+        var bars = timeframeStore.readColumns(null, 0, timeframeStore.getCount());
+        var firstTimestamp = 1000 * 5 * minuteLength;
+
+        assert.strictEqual(timeframeStore.getCount(), 5);
+        assertValuesEqual(bars.timestamp, [0, 5, 10, 60, 65].map(function(minute) {
+            return firstTimestamp + minute * minuteLength;
+        }));
+        assertValuesEqual(bars.open, [99.5, 104.5, 108.5, 110.5, 115.5]);
+        assertValuesEqual(bars.high, [105, 109, 111, 116, 117]);
+        assertValuesEqual(bars.low, [99, 104, 108, 110, 115]);
+        assertValuesEqual(bars.close, [104, 108, 110, 115, 116]);
+        assertValuesEqual(bars.volume, [15, 30, 21, 70, 17]);
+        assertValuesEqual(bars.firstIndex, [0, 5, 9, 11, 16]);
+
+        // The last bar is never complete.
+        assertValuesEqual(bars.completedIndex, [4, 9, 11, 15, 17]);
+    });
+};
+
+module.exports['aligns bars onto the minutes they are complete at, starting over after gaps'] = function() {
+    withFiveMinuteBars(minutes.length, function(timeframeStore, alignedCloses) {
+        assertValuesEqual(alignedCloses, [NaN, NaN, NaN, NaN, 104, 104, 104, 104, 104, 108, 108, NaN, NaN, NaN, NaN, 115, 115]);
+    });
+};
+
+module.exports['aligns each minute the same way without any later minutes'] = function() {
+    var alignedCloses = null;
+    var count = 0;
+
+    withFiveMinuteBars(minutes.length, function(timeframeStore, closes) {
+        alignedCloses = closes;
+    });
+
+    // A value that changed once later minutes were added would have been seen before its bar closed.
+    for (count = 1; count <= minutes.length; count++) {
+        withFiveMinuteBars(count, function(timeframeStore, closes) {
+            assertValuesEqual([closes[count - 1]], [alignedCloses[count - 1]]);
+        });
+    }
+};